@@ -53,15 +53,25 @@
 #define UTIL_WEIGHT .60
 
 /* 
- * Alignment requirement in bytes (either 4 or 8) 
+ * Alignment requirement in bytes (4, 8 or 16) 
  */
-#define ALIGNMENT 8  
+#define ALIGNMENT 16  
 
 /* 
  * Maximum heap size in bytes 
  */
 #define MAX_HEAP (20*(1<<20))  /* 20 MB */
 
+/*
+ * 1 = shrinking or resetting a simulated heap gives the released pages
+ * back to the kernel, as a real sbrk does, so they read as zero again
+ * and calloc can skip clearing them. Regrowing pays the page faults.
+ * 0 = released pages stay mapped and dirty.
+ */
+#ifndef MEM_RELEASE
+#define MEM_RELEASE 1
+#endif
+
 /*****************************************************************************
  * Set exactly one of these USE_xxx constants to "1" to select a timing method
  *****************************************************************************/
@@ -15,6 +15,9 @@
 #include <assert.h>
 #include <float.h>
 #include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/time.h>
 
 extern char *optarg; // Added declaration for optarg
 
@@ -32,8 +35,17 @@ extern char *optarg; // Added declaration for optarg
 #define HDRLINES 4		   /* number of header lines in a trace file */
 #define LINENUM(i) (i + 5) /* cnvt trace request nums to linenums (origin 1) */
 
-/* Returns true if p is ALIGNMENT-byte aligned */
-#define IS_ALIGNED(p) ((((unsigned int)(p)) % ALIGNMENT) == 0)
+/* Producer/consumer benchmark (-p) */
+#define PIPE_MAX_PAIRS 64	/* most producer/consumer pairs */
+#define PIPE_BLOCKS 200000	/* blocks each producer hands to its consumer */
+#define PIPE_SLOTS 256		/* ring buffer entries between a pair */
+
+/* Batch microbenchmark (-b) */
+#define BATCH_MAX 4096		/* most blocks per batch */
+#define BATCH_BLOCKS 1000000	/* blocks each run allocates and frees */
+
+/* Returns true if p is align-byte aligned */
+#define IS_ALIGNED(p, align) ((((unsigned long)(p)) % (align)) == 0)
 
 /******************************
  * The key compound data types
@@ -54,10 +66,16 @@ typedef struct
 	{
 		ALLOC,
 		FREE,
-		REALLOC
+		REALLOC,
+		CALLOC,
+		ALIGNED,
+		BATCH_ALLOC,
+		BATCH_FREE
 	} type;	   /* type of request */
 	int index; /* index for free() to use later */
 	int size;  /* byte size of alloc/realloc request */
+	int align; /* payload alignment of an aligned alloc request */
+	int count; /* number of consecutive ids a batch request covers */
 } traceop_t;
 
 /* Holds the information for one trace file*/
@@ -66,6 +84,7 @@ typedef struct
 	int sugg_heapsize;	 /* suggested heap size (unused) */
 	int num_ids;		 /* number of alloc/realloc ids */
 	int num_ops;		 /* number of distinct requests */
+	int num_calls;		 /* malloc/free calls they stand for (a batch counts each block) */
 	int weight;			 /* weight for this trace (unused) */
 	traceop_t *ops;		 /* array of requests */
 	char **blocks;		 /* array of ptrs returned by malloc/realloc... */
@@ -83,6 +102,14 @@ typedef struct
 	range_t *ranges;
 } speed_t;
 
+/* Params to batch_run, the function timed by the batch microbenchmark */
+typedef struct
+{
+	int n;		   /* blocks per batch */
+	size_t size;   /* payload bytes of every block */
+	int use_batch; /* call mm_malloc_batch/mm_free_batch instead of loops */
+} batch_t;
+
 /* Summarizes the important stats for some malloc function on some trace */
 typedef struct
 {
@@ -93,10 +120,27 @@ typedef struct
 
 	/* defined only for the student malloc package */
 	double util; /* space utilization for this trace (always 0 for libc) */
+	mm_counters_t counters; /* mm event counters from the utilization run */
+	size_t peak_heap;		/* largest heap size during the utilization run */
+	size_t end_heap;		/* heap size after the utilization run */
+	size_t peak_map;		/* most bytes mapped with mem_map during the utilization run */
+	double int_frag;		/* unrequested share of block bytes at peak payload (<0 = not tracked) */
 
 	/* Note: secs and util are only defined if valid is true */
 } stats_t;
 
+/*
+ * Single-producer single-consumer ring between one pair of pipeline
+ * threads. The producer mallocs, the consumer frees.
+ */
+typedef struct
+{
+	char *slot[PIPE_SLOTS];
+	unsigned long head; /* slots filled so far (written by the producer) */
+	unsigned long tail; /* slots emptied so far (written by the consumer) */
+	unsigned int seed;	/* producer's size sequence */
+} pipe_t;
+
 /********************
  * Global variables
  *******************/
@@ -116,7 +160,7 @@ static char *default_tracefiles[] = {
  *********************/
 
 /* these functions manipulate range lists */
-static int add_range(range_t **ranges, char *lo, int size,
+static int add_range(range_t **ranges, char *lo, int size, int align,
 					 int tracenum, int opnum);
 static void remove_range(range_t **ranges, char *lo);
 static void clear_ranges(range_t **ranges);
@@ -129,14 +173,25 @@ static void free_trace(trace_t *trace);
 static int eval_libc_valid(trace_t *trace, int tracenum);
 static void eval_libc_speed(void *ptr);
 
+/* Producer/consumer benchmark for thread-safe mm builds */
+static void *pipe_producer(void *arg);
+static void *pipe_consumer(void *arg);
+static void eval_mm_pipeline(int pairs);
+
+/* Batch microbenchmark: mm_malloc_batch/mm_free_batch against per-call loops */
+static void batch_run(void *ptr);
+static void eval_mm_batch(int n);
+
 /* Routines for evaluating correctnes, space utilization, and speed
    of the student's malloc package in mm.c */
 static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges);
-static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges);
+static int fill_usable(char *p, int size, int index, int tracenum, int opnum);
+static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges, double *int_frag);
 static void eval_mm_speed(void *ptr);
 
 /* Various helper routines */
 static void printresults(int n, stats_t *stats);
+static void printcounters(int n, stats_t *stats);
 static void usage(void);
 static void unix_error(char *msg);
 static void malloc_error(int tracenum, int opnum, char *msg);
@@ -160,6 +215,8 @@ int main(int argc, char **argv)
 	int team_check = 1; /* If set, check team structure (reset by -a) */
 	int run_libc = 0;	/* If set, run libc malloc (set by -l) */
 	int autograder = 0; /* If set, emit summary info for autograder (-g) */
+	int pipe_pairs = 0; /* If set, run only the producer/consumer benchmark (-p) */
+	int batch_n = 0;	/* If set, run only the batch microbenchmark (-b) */
 
 	/* temporaries used to compute the performance index */
 	double secs, ops, util, avg_mm_util, avg_mm_throughput, p1, p2, perfindex;
@@ -168,7 +225,7 @@ int main(int argc, char **argv)
 	/*
 	 * Read and interpret the command line arguments
 	 */
-	while ((c = getopt(argc, argv, "f:t:hvVgal")) != EOF)
+	while ((c = getopt(argc, argv, "f:t:p:b:hvVgal")) != EOF)
 	{
 		printf("getopt returned: %d\n", c); // 디버깅용 출력 추가
 
@@ -195,6 +252,18 @@ int main(int argc, char **argv)
 		case 'a': /* Don't check team structure */
 			team_check = 0;
 			break;
+		case 'p': /* Run the producer/consumer benchmark instead of the traces */
+			pipe_pairs = atoi(optarg);
+			if (pipe_pairs < 1 || pipe_pairs > PIPE_MAX_PAIRS)
+				app_error("-p needs between 1 and 64 producer/consumer pairs");
+			if (!mm_thread_safe)
+				app_error("-p needs a thread-safe mm (THREAD_SAFE, ARENAS, REMOTE_FREE or PERCPU_CACHE build)");
+			break;
+		case 'b': /* Run the batch microbenchmark instead of the traces */
+			batch_n = atoi(optarg);
+			if (batch_n < 1 || batch_n > BATCH_MAX)
+				app_error("-b needs between 1 and 4096 blocks per batch");
+			break;
 		case 'l': /* Run libc malloc */
 			run_libc = 1;
 			break;
@@ -244,6 +313,18 @@ int main(int argc, char **argv)
 			printf("Member 2 :%s:%s\n", team.name2, team.id2);
 	}
 
+	if (pipe_pairs)
+	{
+		eval_mm_pipeline(pipe_pairs);
+		exit(0);
+	}
+
+	if (batch_n)
+	{
+		eval_mm_batch(batch_n);
+		exit(0);
+	}
+
 	/*
 	 * If no -f command line arg, then use the entire set of tracefiles
 	 * defined in default_traces[]
@@ -275,7 +356,7 @@ int main(int argc, char **argv)
 		for (i = 0; i < num_tracefiles; i++)
 		{
 			trace = read_trace(tracedir, tracefiles[i]);
-			libc_stats[i].ops = trace->num_ops;
+			libc_stats[i].ops = trace->num_calls;
 			if (verbose > 1)
 				printf("Checking libc malloc for correctness, ");
 			libc_stats[i].valid = eval_libc_valid(trace, i);
@@ -315,7 +396,7 @@ int main(int argc, char **argv)
 	for (i = 0; i < num_tracefiles; i++)
 	{
 		trace = read_trace(tracedir, tracefiles[i]);
-		mm_stats[i].ops = trace->num_ops;
+		mm_stats[i].ops = trace->num_calls;
 		if (verbose > 1)
 			printf("Checking mm_malloc for correctness, ");
 		mm_stats[i].valid = eval_mm_valid(trace, i, &ranges);
@@ -323,7 +404,11 @@ int main(int argc, char **argv)
 		{
 			if (verbose > 1)
 				printf("efficiency, ");
-			mm_stats[i].util = eval_mm_util(trace, i, &ranges);
+			mm_stats[i].util = eval_mm_util(trace, i, &ranges, &mm_stats[i].int_frag);
+			mm_stats[i].counters = mm_counters;
+			mm_stats[i].peak_heap = mem_heap_peak();
+			mm_stats[i].end_heap = mem_heapsize();
+			mm_stats[i].peak_map = mem_map_peak();
 			speed_params.trace = trace;
 			speed_params.ranges = ranges;
 			if (verbose > 1)
@@ -338,6 +423,8 @@ int main(int argc, char **argv)
 	{
 		printf("\nResults for mm malloc:\n");
 		printresults(num_tracefiles, mm_stats);
+		printf("\nAllocator counters for mm malloc:\n");
+		printcounters(num_tracefiles, mm_stats);
 		printf("\n");
 	}
 
@@ -406,10 +493,11 @@ int main(int argc, char **argv)
 /*
  * add_range - As directed by request opnum in trace tracenum,
  *     we've just called the student's mm_malloc to allocate a block of
- *     size bytes at addr lo. After checking the block for correctness,
- *     we create a range struct for this block and add it to the range list.
+ *     size bytes at addr lo, which must be align-byte aligned. After
+ *     checking the block for correctness, we create a range struct for
+ *     this block and add it to the range list.
  */
-static int add_range(range_t **ranges, char *lo, int size,
+static int add_range(range_t **ranges, char *lo, int size, int align,
 					 int tracenum, int opnum)
 {
 	char *hi = lo + size - 1;
@@ -418,18 +506,23 @@ static int add_range(range_t **ranges, char *lo, int size,
 
 	assert(size > 0);
 
-	/* Payload addresses must be ALIGNMENT-byte aligned */
-	if (!IS_ALIGNED(lo))
+	/* Payload addresses must be ALIGNMENT-byte aligned, or more for
+	   aligned alloc requests */
+	if (align < ALIGNMENT)
+		align = ALIGNMENT;
+	if (!IS_ALIGNED(lo, align))
 	{
 		sprintf(msg, "Payload address (%p) not aligned to %d bytes",
-				lo, ALIGNMENT);
+				lo, align);
 		malloc_error(tracenum, opnum, msg);
 		return 0;
 	}
 
-	/* The payload must lie within the extent of the heap */
-	if ((lo < (char *)mem_heap_lo()) || (lo > (char *)mem_heap_hi()) ||
-		(hi < (char *)mem_heap_lo()) || (hi > (char *)mem_heap_hi()))
+	/* The payload must lie within the extent of the heap, or entirely
+	   within the mem_map area */
+	if (((lo < (char *)mem_heap_lo()) || (lo > (char *)mem_heap_hi()) ||
+		 (hi < (char *)mem_heap_lo()) || (hi > (char *)mem_heap_hi())) &&
+		!(mem_is_mapped(lo) && mem_is_mapped(hi)))
 	{
 		sprintf(msg, "Payload (%p:%p) lies outside heap (%p:%p)",
 				lo, hi, mem_heap_lo(), mem_heap_hi());
@@ -514,7 +607,7 @@ static trace_t *read_trace(char *tracedir, char *filename)
 	trace_t *trace;
 	char type[MAXLINE];
 	char path[MAXLINE];
-	unsigned index, size;
+	unsigned index, size, align, count;
 	unsigned max_index = 0;
 	unsigned op_index;
 
@@ -556,8 +649,11 @@ static trace_t *read_trace(char *tracedir, char *filename)
 	/* read every request line in the trace file */
 	index = 0;
 	op_index = 0;
+	trace->num_calls = 0;
 	while (fscanf(tracefile, "%s", type) != EOF)
 	{
+		trace->ops[op_index].align = 0;
+		trace->ops[op_index].count = 1;
 		switch (type[0])
 		{
 		case 'a':
@@ -574,16 +670,62 @@ static trace_t *read_trace(char *tracedir, char *filename)
 			trace->ops[op_index].size = size;
 			max_index = (index > max_index) ? index : max_index;
 			break;
+		case 'm':
+			fscanf(tracefile, "%u %u %u", &index, &align, &size);
+			if (align == 0 || (align & (align - 1)) != 0)
+			{
+				printf("Alignment %u is not a power of 2 in tracefile %s\n",
+					   align, path);
+				exit(1);
+			}
+			trace->ops[op_index].type = ALIGNED;
+			trace->ops[op_index].index = index;
+			trace->ops[op_index].size = size;
+			trace->ops[op_index].align = align;
+			max_index = (index > max_index) ? index : max_index;
+			break;
+		case 'c':
+			fscanf(tracefile, "%u %u", &index, &size);
+			trace->ops[op_index].type = CALLOC;
+			trace->ops[op_index].index = index;
+			trace->ops[op_index].size = size;
+			max_index = (index > max_index) ? index : max_index;
+			break;
 		case 'f':
 			fscanf(tracefile, "%ud", &index);
 			trace->ops[op_index].type = FREE;
 			trace->ops[op_index].index = index;
 			break;
+		case 'A':
+			fscanf(tracefile, "%u %u %u", &index, &count, &size);
+			if (count == 0)
+			{
+				printf("Empty batch in tracefile %s\n", path);
+				exit(1);
+			}
+			trace->ops[op_index].type = BATCH_ALLOC;
+			trace->ops[op_index].index = index;
+			trace->ops[op_index].size = size;
+			trace->ops[op_index].count = count;
+			max_index = (index + count - 1 > max_index) ? index + count - 1 : max_index;
+			break;
+		case 'F':
+			fscanf(tracefile, "%u %u", &index, &count);
+			if (count == 0)
+			{
+				printf("Empty batch in tracefile %s\n", path);
+				exit(1);
+			}
+			trace->ops[op_index].type = BATCH_FREE;
+			trace->ops[op_index].index = index;
+			trace->ops[op_index].count = count;
+			break;
 		default:
 			printf("Bogus type character (%c) in tracefile %s\n",
 				   type[0], path);
 			exit(1);
 		}
+		trace->num_calls += trace->ops[op_index].count;
 		op_index++;
 	}
 	fclose(tracefile);
@@ -610,14 +752,32 @@ void free_trace(trace_t *trace)
  * and throughput of the libc and mm malloc packages.
  **********************************************************************/
 
+/*
+ * mm_alloc_op - Run an allocating request (malloc, calloc, or
+ *     memalign) through the mm package
+ */
+static char *mm_alloc_op(traceop_t *op)
+{
+	switch (op->type)
+	{
+	case CALLOC:
+		return mm_calloc(1, op->size);
+	case ALIGNED:
+		return mm_memalign(op->align, op->size);
+	default:
+		return mm_malloc(op->size);
+	}
+}
+
 /*
  * eval_mm_valid - Check the mm malloc package for correctness
  */
 static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 {
-	int i, j;
+	int i, j, k;
 	int index;
 	int size;
+	int count;
 	int oldsize;
 	char *newp;
 	char *oldp;
@@ -644,9 +804,11 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 		{
 
 		case ALLOC: /* mm_malloc */
+		case CALLOC: /* mm_calloc */
+		case ALIGNED: /* mm_memalign */
 
-			/* Call the student's malloc */
-			if ((p = mm_malloc(size)) == NULL)
+			/* Call the student's malloc, calloc, or memalign */
+			if ((p = mm_alloc_op(&trace->ops[i])) == NULL)
 			{
 				malloc_error(tracenum, i, "mm_malloc failed.");
 				return 0;
@@ -657,15 +819,26 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 			 * to the range list if OK. The block must be  be aligned properly,
 			 * and must not overlap any currently allocated block.
 			 */
-			if (add_range(ranges, p, size, tracenum, i) == 0)
+			if (add_range(ranges, p, size, trace->ops[i].align, tracenum, i) == 0)
 				return 0;
 
+			/* A calloc'ed block must read as zero before we fill it */
+			for (j = 0; trace->ops[i].type == CALLOC && j < size; j++)
+			{
+				if (p[j] != 0)
+				{
+					malloc_error(tracenum, i, "mm_calloc did not zero the block");
+					return 0;
+				}
+			}
+
 			/* ADDED: cgw
 			 * fill range with low byte of index.  This will be used later
 			 * if we realloc the block and wish to make sure that the old
 			 * data was copied to the new block
 			 */
-			memset(p, index & 0xFF, size);
+			if (fill_usable(p, size, index, tracenum, i) == 0)
+				return 0;
 
 			/* Remember region */
 			trace->blocks[index] = p;
@@ -686,7 +859,7 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 			remove_range(ranges, oldp);
 
 			/* Check new block for correctness and add it to range list */
-			if (add_range(ranges, newp, size, tracenum, i) == 0)
+			if (add_range(ranges, newp, size, ALIGNMENT, tracenum, i) == 0)
 				return 0;
 
 			/* ADDED: cgw
@@ -699,14 +872,15 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 				oldsize = size;
 			for (j = 0; j < oldsize; j++)
 			{
-				if (newp[j] != (index & 0xFF))
+				if ((unsigned char)newp[j] != (index & 0xFF))
 				{
 					malloc_error(tracenum, i, "mm_realloc did not preserve the "
 											  "data from old block");
 					return 0;
 				}
 			}
-			memset(newp, index & 0xFF, size);
+			if (fill_usable(newp, size, index, tracenum, i) == 0)
+				return 0;
 
 			/* Remember region */
 			trace->blocks[index] = newp;
@@ -721,6 +895,37 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 			mm_free(p);
 			break;
 
+		case BATCH_ALLOC: /* mm_malloc_batch */
+
+			/* Blocks land straight in the slots of their consecutive ids */
+			count = trace->ops[i].count;
+			if (mm_malloc_batch((void **)&trace->blocks[index], count, size) != (size_t)count)
+			{
+				malloc_error(tracenum, i, "mm_malloc_batch failed.");
+				return 0;
+			}
+
+			/* Check and fill every block like a single malloc */
+			for (k = 0; k < count; k++)
+			{
+				p = trace->blocks[index + k];
+				if (add_range(ranges, p, size, ALIGNMENT, tracenum, i) == 0)
+					return 0;
+				if (fill_usable(p, size, index + k, tracenum, i) == 0)
+					return 0;
+				trace->block_sizes[index + k] = size;
+			}
+			break;
+
+		case BATCH_FREE: /* mm_free_batch */
+
+			/* mm_free_batch may reorder the slots; the ids are dead after it */
+			count = trace->ops[i].count;
+			for (k = 0; k < count; k++)
+				remove_range(ranges, trace->blocks[index + k]);
+			mm_free_batch((void **)&trace->blocks[index], count);
+			break;
+
 		default:
 			app_error("Nonexistent request type in eval_mm_valid");
 		}
@@ -730,24 +935,46 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	return 1;
 }
 
+/*
+ * fill_usable - Check that mm_usable_size covers the request and fill
+ *     the whole usable area with the low byte of index, so slack that
+ *     the package does not really own shows up as a corrupted block
+ */
+static int fill_usable(char *p, int size, int index, int tracenum, int opnum)
+{
+	size_t usable = mm_usable_size(p);
+
+	if (usable < (size_t)size)
+	{
+		malloc_error(tracenum, opnum, "mm_usable_size is smaller than the request");
+		return 0;
+	}
+	memset(p, index & 0xFF, usable);
+	return 1;
+}
+
 /*
  * eval_mm_util - Evaluate the space utilization of the student's package
  *   The idea is to remember the high water mark "hwm" of the heap for
  *   an optimal allocator, i.e., no gaps and no internal fragmentation.
  *   Utilization is the ratio hwm/heapsize, where heapsize is the
- *   size of the heap in bytes after running the student's malloc
- *   package on the trace. Note that our implementation of mem_sbrk()
- *   doesn't allow the students to decrement the brk pointer, so brk
- *   is always the high water mark of the heap.
+ *   peak size of the heap in bytes while running the student's malloc
+ *   package on the trace. mem_sbrk() lets the package shrink the heap,
+ *   so the peak rather than the final brk is used; trimming the heap
+ *   at the end of a trace does not raise the score.
  *
+ *   If the package tracks mm_counters.live_block_bytes, *int_frag is
+ *   set to the share of block bytes that were not requested at the
+ *   moment the payload peaked (internal fragmentation); otherwise -1.
  */
-static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
+static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges, double *int_frag)
 {
-	int i;
+	int i, k;
 	int index;
 	int size, newsize, oldsize;
 	int max_total_size = 0;
 	int total_size = 0;
+	unsigned long peak_blocks = 0;
 	char *p;
 	char *newp, *oldp;
 
@@ -762,10 +989,12 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 		{
 
 		case ALLOC: /* mm_alloc */
+		case CALLOC: /* mm_calloc */
+		case ALIGNED: /* mm_memalign */
 			index = trace->ops[i].index;
 			size = trace->ops[i].size;
 
-			if ((p = mm_malloc(size)) == NULL)
+			if ((p = mm_alloc_op(&trace->ops[i])) == NULL)
 				app_error("mm_malloc failed in eval_mm_util");
 
 			/* Remember region and size */
@@ -777,7 +1006,11 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 			total_size += size;
 
 			/* Update statistics */
-			max_total_size = (total_size > max_total_size) ? total_size : max_total_size;
+			if (total_size > max_total_size)
+			{
+				max_total_size = total_size;
+				peak_blocks = mm_counters.live_block_bytes;
+			}
 			break;
 
 		case REALLOC: /* mm_realloc */
@@ -798,7 +1031,11 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 			total_size += (newsize - oldsize);
 
 			/* Update statistics */
-			max_total_size = (total_size > max_total_size) ? total_size : max_total_size;
+			if (total_size > max_total_size)
+			{
+				max_total_size = total_size;
+				peak_blocks = mm_counters.live_block_bytes;
+			}
 			break;
 
 		case FREE: /* mm_free */
@@ -814,12 +1051,39 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 
 			break;
 
+		case BATCH_ALLOC: /* mm_malloc_batch */
+			index = trace->ops[i].index;
+			size = trace->ops[i].size;
+
+			if (mm_malloc_batch((void **)&trace->blocks[index], trace->ops[i].count, size) !=
+				(size_t)trace->ops[i].count)
+				app_error("mm_malloc_batch failed in eval_mm_util");
+			for (k = 0; k < trace->ops[i].count; k++)
+				trace->block_sizes[index + k] = size;
+
+			total_size += trace->ops[i].count * size;
+			if (total_size > max_total_size)
+			{
+				max_total_size = total_size;
+				peak_blocks = mm_counters.live_block_bytes;
+			}
+			break;
+
+		case BATCH_FREE: /* mm_free_batch */
+			index = trace->ops[i].index;
+			for (k = 0; k < trace->ops[i].count; k++)
+				total_size -= trace->block_sizes[index + k];
+			mm_free_batch((void **)&trace->blocks[index], trace->ops[i].count);
+			break;
+
 		default:
 			app_error("Nonexistent request type in eval_mm_util");
 		}
 	}
 
-	return ((double)max_total_size / (double)mem_heapsize());
+	*int_frag = (peak_blocks > 0) ? 1.0 - (double)max_total_size / (double)peak_blocks : -1.0;
+	/* Footprint = sbrk heap plus pages mapped with mem_map, at their joint peak */
+	return ((double)max_total_size / (double)mem_footprint_peak());
 }
 
 /*
@@ -850,6 +1114,22 @@ static void eval_mm_speed(void *ptr)
 			trace->blocks[index] = p;
 			break;
 
+		case CALLOC: /* mm_calloc */
+			index = trace->ops[i].index;
+			size = trace->ops[i].size;
+			if ((p = mm_calloc(1, size)) == NULL)
+				app_error("mm_calloc error in eval_mm_speed");
+			trace->blocks[index] = p;
+			break;
+
+		case ALIGNED: /* mm_memalign */
+			index = trace->ops[i].index;
+			size = trace->ops[i].size;
+			if ((p = mm_memalign(trace->ops[i].align, size)) == NULL)
+				app_error("mm_memalign error in eval_mm_speed");
+			trace->blocks[index] = p;
+			break;
+
 		case REALLOC: /* mm_realloc */
 			index = trace->ops[i].index;
 			newsize = trace->ops[i].size;
@@ -865,6 +1145,18 @@ static void eval_mm_speed(void *ptr)
 			mm_free(block);
 			break;
 
+		case BATCH_ALLOC: /* mm_malloc_batch */
+			index = trace->ops[i].index;
+			if (mm_malloc_batch((void **)&trace->blocks[index], trace->ops[i].count,
+								trace->ops[i].size) != (size_t)trace->ops[i].count)
+				app_error("mm_malloc_batch error in eval_mm_speed");
+			break;
+
+		case BATCH_FREE: /* mm_free_batch */
+			index = trace->ops[i].index;
+			mm_free_batch((void **)&trace->blocks[index], trace->ops[i].count);
+			break;
+
 		default:
 			app_error("Nonexistent request type in eval_mm_valid");
 		}
@@ -878,7 +1170,7 @@ static void eval_mm_speed(void *ptr)
  */
 static int eval_libc_valid(trace_t *trace, int tracenum)
 {
-	int i, newsize;
+	int i, k, newsize;
 	char *p, *newp, *oldp;
 
 	for (i = 0; i < trace->num_ops; i++)
@@ -895,6 +1187,24 @@ static int eval_libc_valid(trace_t *trace, int tracenum)
 			trace->blocks[trace->ops[i].index] = p;
 			break;
 
+		case CALLOC: /* calloc */
+			if ((p = calloc(1, trace->ops[i].size)) == NULL)
+			{
+				malloc_error(tracenum, i, "libc calloc failed");
+				unix_error("System message");
+			}
+			trace->blocks[trace->ops[i].index] = p;
+			break;
+
+		case ALIGNED: /* posix_memalign */
+			if (posix_memalign((void **)&p, trace->ops[i].align, trace->ops[i].size) != 0)
+			{
+				malloc_error(tracenum, i, "libc posix_memalign failed");
+				unix_error("System message");
+			}
+			trace->blocks[trace->ops[i].index] = p;
+			break;
+
 		case REALLOC: /* realloc */
 			newsize = trace->ops[i].size;
 			oldp = trace->blocks[trace->ops[i].index];
@@ -910,6 +1220,23 @@ static int eval_libc_valid(trace_t *trace, int tracenum)
 			free(trace->blocks[trace->ops[i].index]);
 			break;
 
+		case BATCH_ALLOC: /* malloc loop */
+			for (k = 0; k < trace->ops[i].count; k++)
+			{
+				if ((p = malloc(trace->ops[i].size)) == NULL)
+				{
+					malloc_error(tracenum, i, "libc malloc failed");
+					unix_error("System message");
+				}
+				trace->blocks[trace->ops[i].index + k] = p;
+			}
+			break;
+
+		case BATCH_FREE: /* free loop */
+			for (k = 0; k < trace->ops[i].count; k++)
+				free(trace->blocks[trace->ops[i].index + k]);
+			break;
+
 		default:
 			app_error("invalid operation type  in eval_libc_valid");
 		}
@@ -925,7 +1252,7 @@ static int eval_libc_valid(trace_t *trace, int tracenum)
  */
 static void eval_libc_speed(void *ptr)
 {
-	int i;
+	int i, k;
 	int index, size, newsize;
 	char *p, *newp, *oldp, *block;
 	trace_t *trace = ((speed_t *)ptr)->trace;
@@ -942,6 +1269,22 @@ static void eval_libc_speed(void *ptr)
 			trace->blocks[index] = p;
 			break;
 
+		case CALLOC: /* calloc */
+			index = trace->ops[i].index;
+			size = trace->ops[i].size;
+			if ((p = calloc(1, size)) == NULL)
+				unix_error("calloc failed in eval_libc_speed");
+			trace->blocks[index] = p;
+			break;
+
+		case ALIGNED: /* posix_memalign */
+			index = trace->ops[i].index;
+			size = trace->ops[i].size;
+			if (posix_memalign((void **)&p, trace->ops[i].align, size) != 0)
+				unix_error("posix_memalign failed in eval_libc_speed");
+			trace->blocks[index] = p;
+			break;
+
 		case REALLOC: /* realloc */
 			index = trace->ops[i].index;
 			newsize = trace->ops[i].size;
@@ -957,10 +1300,207 @@ static void eval_libc_speed(void *ptr)
 			block = trace->blocks[index];
 			free(block);
 			break;
+
+		case BATCH_ALLOC: /* malloc loop */
+			index = trace->ops[i].index;
+			size = trace->ops[i].size;
+			for (k = 0; k < trace->ops[i].count; k++)
+				if ((trace->blocks[index + k] = malloc(size)) == NULL)
+					unix_error("malloc failed in eval_libc_speed");
+			break;
+
+		case BATCH_FREE: /* free loop */
+			index = trace->ops[i].index;
+			for (k = 0; k < trace->ops[i].count; k++)
+				free(trace->blocks[index + k]);
+			break;
+		}
+	}
+}
+
+/*
+ * pipe_producer - Allocates PIPE_BLOCKS blocks, stamps each with its
+ *    size and passes them to the consumer. Sizes are mostly small
+ *    (16-512 bytes) with an occasional 1-4 KB block.
+ */
+static void *pipe_producer(void *arg)
+{
+	pipe_t *pipe = arg;
+	unsigned long i;
+	size_t size;
+	char *p;
+
+	for (i = 0; i < PIPE_BLOCKS; i++)
+	{
+		pipe->seed = pipe->seed * 1103515245 + 12345;
+		if ((pipe->seed >> 8) % 16 == 0)
+			size = 1024 + (pipe->seed >> 12) % 3072;
+		else
+			size = 16 + (pipe->seed >> 12) % 497;
+		if ((p = mm_malloc(size)) == NULL)
+			app_error("mm_malloc failed in pipe_producer");
+		*(size_t *)p = size;
+		p[size - 1] = (char)size;
+
+		while (i - __atomic_load_n(&pipe->tail, __ATOMIC_ACQUIRE) >= PIPE_SLOTS)
+			sched_yield();
+		pipe->slot[i % PIPE_SLOTS] = p;
+		__atomic_store_n(&pipe->head, i + 1, __ATOMIC_RELEASE);
+	}
+	return NULL;
+}
+
+/*
+ * pipe_consumer - Checks and frees every block its producer hands over
+ */
+static void *pipe_consumer(void *arg)
+{
+	pipe_t *pipe = arg;
+	unsigned long i;
+	size_t size;
+	char *p;
+
+	for (i = 0; i < PIPE_BLOCKS; i++)
+	{
+		while (__atomic_load_n(&pipe->head, __ATOMIC_ACQUIRE) == i)
+			sched_yield();
+		p = pipe->slot[i % PIPE_SLOTS];
+		size = *(size_t *)p;
+		if (p[size - 1] != (char)size)
+			app_error("Payload corrupted in pipe_consumer");
+		mm_free(p);
+		__atomic_store_n(&pipe->tail, i + 1, __ATOMIC_RELEASE);
+	}
+	return NULL;
+}
+
+/*
+ * eval_mm_pipeline - Runs pairs producer/consumer thread pairs on one
+ *    mm heap and reports throughput and the mm lock counters. Every
+ *    block is freed by a different thread than the one that allocated
+ *    it, so this measures cross-thread free cost. Only meaningful for
+ *    mm builds compiled with -DTHREAD_SAFE=1 (or -DARENAS / -DREMOTE_FREE).
+ */
+static void eval_mm_pipeline(int pairs)
+{
+	pthread_t producers[PIPE_MAX_PAIRS], consumers[PIPE_MAX_PAIRS];
+	pipe_t *pipes;
+	struct timeval start, end;
+	double secs;
+	int i;
+
+	if ((pipes = calloc(pairs, sizeof(pipe_t))) == NULL)
+		unix_error("pipes calloc in eval_mm_pipeline failed");
+	mem_init();
+	if (mm_init() < 0)
+		app_error("mm_init failed in eval_mm_pipeline");
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < pairs; i++)
+	{
+		pipes[i].seed = i + 1;
+		if (pthread_create(&producers[i], NULL, pipe_producer, &pipes[i]) != 0 ||
+			pthread_create(&consumers[i], NULL, pipe_consumer, &pipes[i]) != 0)
+			unix_error("pthread_create failed in eval_mm_pipeline");
+	}
+	for (i = 0; i < pairs; i++)
+	{
+		pthread_join(producers[i], NULL);
+		pthread_join(consumers[i], NULL);
+	}
+	gettimeofday(&end, NULL);
+	secs = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+
+	printf("Producer/consumer: %d pairs x %d blocks\n", pairs, PIPE_BLOCKS);
+	printf("%10s%12s%12s%14s\n", "secs", "Kops/s", "lock waits", "remote frees");
+	printf("%10.3f%12.0f%12lu%14lu\n", secs,
+		   2.0 * pairs * PIPE_BLOCKS / secs / 1e3,
+		   mm_counters.lock_waits, mm_counters.remote_frees);
+	free(pipes);
+	mem_deinit();
+}
+
+/*
+ * batch_run - Allocates BATCH_BLOCKS blocks of one size in batches of
+ *    n, like a parser building one message's nodes, and frees each
+ *    batch after the next one is allocated so two messages are live at
+ *    a time. Uses mm_malloc_batch/mm_free_batch or per-call loops.
+ */
+static void batch_run(void *ptr)
+{
+	batch_t *b = ptr;
+	static void *blocks[2][BATCH_MAX];
+	void **cur, **prev;
+	int round, k;
+
+	mem_reset_brk();
+	if (mm_init() < 0)
+		app_error("mm_init failed in batch_run");
+
+	for (round = 0; round < BATCH_BLOCKS / b->n; round++)
+	{
+		cur = blocks[round % 2];
+		prev = blocks[(round + 1) % 2];
+		if (b->use_batch)
+		{
+			if (mm_malloc_batch(cur, b->n, b->size) != (size_t)b->n)
+				app_error("mm_malloc_batch failed in batch_run");
 		}
+		else
+		{
+			for (k = 0; k < b->n; k++)
+				if ((cur[k] = mm_malloc(b->size)) == NULL)
+					app_error("mm_malloc failed in batch_run");
+		}
+		for (k = 0; k < b->n; k++)
+			*(char *)cur[k] = (char)k;
+		if (round == 0)
+			continue;
+		if (b->use_batch)
+			mm_free_batch(prev, b->n);
+		else
+			for (k = 0; k < b->n; k++)
+				mm_free(prev[k]);
 	}
 }
 
+/*
+ * eval_mm_batch - Times batch_run with per-call loops and with the
+ *    batch calls for a run-slot size and a plain block size, and
+ *    reports throughput and the peak heap of each.
+ */
+static void eval_mm_batch(int n)
+{
+	static const size_t sizes[] = {48, 256};
+	batch_t b;
+	double secs[2];
+	size_t peak[2];
+	int i;
+
+	init_fsecs();
+	mem_init();
+	printf("Batch microbenchmark: %d blocks per batch, %d blocks per run\n",
+		   n, BATCH_BLOCKS / n * n);
+	printf("%6s%12s%12s%9s%12s%12s\n",
+		   "size", "loop Kops", "batch Kops", "speedup", "loop peak", "batch peak");
+	for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++)
+	{
+		b.n = n;
+		b.size = sizes[i];
+		for (b.use_batch = 0; b.use_batch <= 1; b.use_batch++)
+		{
+			secs[b.use_batch] = fsecs(batch_run, &b);
+			batch_run(&b);
+			peak[b.use_batch] = mem_heap_peak();
+		}
+		printf("%6lu%12.0f%12.0f%8.2fx%12lu%12lu\n", (unsigned long)b.size,
+			   2.0 * (BATCH_BLOCKS / n * n) / secs[0] / 1e3,
+			   2.0 * (BATCH_BLOCKS / n * n) / secs[1] / 1e3,
+			   secs[0] / secs[1], (unsigned long)peak[0], (unsigned long)peak[1]);
+	}
+	mem_deinit();
+}
+
 /*************************************
  * Some miscellaneous helper routines
  ************************************/
@@ -1026,6 +1566,42 @@ static void printresults(int n, stats_t *stats)
 	}
 }
 
+/*
+ * printcounters - prints the mm package's event counters, the peak
+ *   and final heap sizes, the peak mapped bytes, the calloc bytes the
+ *   package did not have to clear, and the internal fragmentation for each trace
+ */
+static void printcounters(int n, stats_t *stats)
+{
+	int i;
+
+	printf("%5s%12s%8s%10s%12s%11s%10s%10s%10s%10s\n",
+		   "trace", "coal-avoid", "consol", "re-moves", "re-copied",
+		   "peak heap", "end heap", "peak map", "cal-skip", "int-frag");
+	for (i = 0; i < n; i++)
+	{
+		if (stats[i].valid)
+		{
+			printf("%2d%15lu%8lu%10lu%12lu%11lu%10lu%10lu%10lu",
+				   i,
+				   stats[i].counters.coalesce_avoided,
+				   stats[i].counters.consolidations,
+				   stats[i].counters.realloc_moves,
+				   stats[i].counters.realloc_copy_bytes,
+				   (unsigned long)stats[i].peak_heap,
+				   (unsigned long)stats[i].end_heap,
+				   (unsigned long)stats[i].peak_map,
+				   stats[i].counters.calloc_clear_skipped);
+			if (stats[i].int_frag >= 0)
+				printf("%9.1f%%\n", stats[i].int_frag * 100.0);
+			else
+				printf("%10s\n", "-");
+		}
+		else
+			printf("%2d%15s%8s%10s%12s%11s%10s%10s%10s%10s\n", i, "-", "-", "-", "-", "-", "-", "-", "-", "-");
+	}
+}
+
 /*
  * app_error - Report an arbitrary application error
  */
@@ -1058,13 +1634,15 @@ void malloc_error(int tracenum, int opnum, char *msg)
  */
 static void usage(void)
 {
-	fprintf(stderr, "Usage: mdriver [-hvVal] [-f <file>] [-t <dir>]\n");
+	fprintf(stderr, "Usage: mdriver [-hvVal] [-f <file>] [-t <dir>] [-p <pairs>] [-b <n>]\n");
 	fprintf(stderr, "Options\n");
 	fprintf(stderr, "\t-a         Don't check the team structure.\n");
+	fprintf(stderr, "\t-b <n>     Run only the batch microbenchmark, n blocks per batch.\n");
 	fprintf(stderr, "\t-f <file>  Use <file> as the trace file.\n");
 	fprintf(stderr, "\t-g         Generate summary info for autograder.\n");
 	fprintf(stderr, "\t-h         Print this message.\n");
 	fprintf(stderr, "\t-l         Run libc malloc as well.\n");
+	fprintf(stderr, "\t-p <pairs> Run only the producer/consumer benchmark (thread-safe mm).\n");
 	fprintf(stderr, "\t-t <dir>   Directory to find default traces.\n");
 	fprintf(stderr, "\t-v         Print per-trace performance breakdowns.\n");
 	fprintf(stderr, "\t-V         Print additional debug info.\n");
@@ -10,14 +10,142 @@
 #include <sys/mman.h>
 #include <string.h>
 #include <errno.h>
+#include <pthread.h>
 
 #include "memlib.h"
 #include "config.h"
 
+/*
+ * Each region is an independent simulated heap with its own brk.
+ * Region 0 is the heap that mem_sbrk and friends operate on; more
+ * regions are handed out by mem_region_new, one per allocator arena.
+ *
+ * The storage is anonymous mmap'ed memory, so bytes never handed out
+ * read as zero. With MEM_RELEASE, shrinking or resetting a region gives
+ * the released whole pages back to the kernel (region_release), so they
+ * read as zero again too. Bytes below zero_brk are dirty and are NOT
+ * cleared when the brk grows back over them. mem_region_clean tells a
+ * caller that relies on zeroed memory (calloc) where the clean part
+ * starts, and it clears the rest itself.
+ */
+typedef struct {
+    char *start_brk;  /* points to first byte of heap */
+    char *brk;        /* points to last byte of heap */
+    char *max_addr;   /* largest legal heap address */
+    char *peak_brk;   /* highest brk reached since the last reset */
+    char *zero_brk;   /* every byte from here to max_addr was never handed out */
+} region_t;
+
 /* private variables */
-static char *mem_start_brk;  /* points to first byte of heap */
-static char *mem_brk;        /* points to last byte of heap */
-static char *mem_max_addr;   /* largest legal heap address */ 
+static region_t regions[MEM_MAX_REGIONS];
+static int region_count;      /* regions in use, published with release order */
+
+/*
+ * The mapping area models mmap/munmap: MAX_HEAP bytes split into
+ * MEM_MAP_PAGE pages, handed out as first-fit runs of whole pages.
+ * It is separate from every sbrk region.
+ */
+#define MAP_PAGES (MAX_HEAP / MEM_MAP_PAGE)
+
+static char *map_start;                  /* first byte of the mapping area */
+static unsigned char map_used[MAP_PAGES]; /* 1 = page is mapped */
+static unsigned char map_dirty[MAP_PAGES]; /* 1 = page was mapped before, clear it on the next map */
+static size_t map_bytes;                 /* bytes currently mapped */
+static size_t map_peak;                  /* most bytes mapped since the last reset */
+static size_t footprint_peak;            /* most region 0 + mapped bytes since the last reset */
+static pthread_mutex_t map_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * footprint_note - raise footprint_peak to the current region 0 size
+ *    plus mapped bytes. Called after either one grows, possibly from
+ *    different threads.
+ */
+static void footprint_note(void)
+{
+    size_t now = (size_t)(__atomic_load_n(&regions[0].brk, __ATOMIC_RELAXED) - regions[0].start_brk) +
+	__atomic_load_n(&map_bytes, __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&footprint_peak, __ATOMIC_RELAXED);
+
+    while (now > peak &&
+	   !__atomic_compare_exchange_n(&footprint_peak, &peak, now, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+	;
+}
+
+/*
+ * anon_alloc - reserve bytes of zero-filled anonymous memory, or NULL
+ */
+static char *anon_alloc(size_t bytes)
+{
+    void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    return (p == MAP_FAILED) ? NULL : (char *)p;
+}
+
+#if MEM_RELEASE
+/* Regions are aligned to this so released heap faults back in as transparent huge pages */
+#define HUGE_PAGE (2 * (1 << 20))
+
+/*
+ * huge_alloc - anon_alloc aligned to HUGE_PAGE and advised to use
+ *    huge pages, or NULL
+ */
+static char *huge_alloc(size_t bytes)
+{
+    char *p = anon_alloc(bytes + HUGE_PAGE);
+    size_t head;
+
+    if (p == NULL)
+	return NULL;
+    head = (HUGE_PAGE - (size_t)p % HUGE_PAGE) % HUGE_PAGE;
+    if (head > 0)
+	munmap(p, head);
+    munmap(p + head + bytes, HUGE_PAGE - head);
+#ifdef MADV_HUGEPAGE
+    madvise(p + head, bytes, MADV_HUGEPAGE);   /* only a hint */
+#endif
+    return p + head;
+}
+#else
+#define huge_alloc anon_alloc
+#endif
+
+/*
+ * region_release - give every whole page of region rg from addr up to
+ *    zero_brk back to the kernel, so they read as zero on the next
+ *    touch, and lower zero_brk to the first of them. The bytes from
+ *    addr to the next page boundary stay dirty.
+ */
+static void region_release(region_t *rg, char *addr)
+{
+#if MEM_RELEASE
+    size_t page = (size_t)getpagesize();
+    char *from = rg->start_brk + ((size_t)(addr - rg->start_brk) + page - 1) / page * page;
+
+    if (from >= rg->zero_brk)
+	return;
+    if (madvise(from, (size_t)(rg->zero_brk - from), MADV_DONTNEED) == 0)
+	rg->zero_brk = from;
+#endif
+}
+
+/*
+ * region_alloc - reserve the storage for region r if it has none yet.
+ *    The storage is kept across resets so region addresses stay stable.
+ */
+static int region_alloc(int r)
+{
+    region_t *rg = &regions[r];
+
+    if (rg->start_brk == NULL) {
+	if ((rg->start_brk = huge_alloc(MAX_HEAP)) == NULL)
+	    return -1;
+	rg->max_addr = rg->start_brk + MAX_HEAP;  /* max legal heap address */
+	rg->zero_brk = rg->start_brk;
+    }
+    rg->brk = rg->start_brk;                  /* heap is empty initially */
+    rg->peak_brk = rg->start_brk;
+    return 0;
+}
 
 /* 
  * mem_init - initialize the memory system model
@@ -25,13 +153,12 @@ static char *mem_max_addr;   /* largest legal heap address */
 void mem_init(void)
 {
     /* allocate the storage we will use to model the available VM */
-    if ((mem_start_brk = (char *)malloc(MAX_HEAP)) == NULL) {
-	fprintf(stderr, "mem_init_vm: malloc error\n");
+    if (region_alloc(0) < 0 ||
+	(map_start == NULL && (map_start = anon_alloc(MAX_HEAP)) == NULL)) {
+	fprintf(stderr, "mem_init_vm: mmap error\n");
 	exit(1);
     }
-
-    mem_max_addr = mem_start_brk + MAX_HEAP;  /* max legal heap address */
-    mem_brk = mem_start_brk;                  /* heap is empty initially */
+    region_count = 1;
 }
 
 /* 
@@ -39,41 +166,151 @@ void mem_init(void)
  */
 void mem_deinit(void)
 {
-    free(mem_start_brk);
+    int r;
+
+    for (r = 0; r < MEM_MAX_REGIONS; r++) {
+	if (regions[r].start_brk != NULL)
+	    munmap(regions[r].start_brk, MAX_HEAP);
+	regions[r].start_brk = NULL;
+    }
+    region_count = 0;
+    if (map_start != NULL)
+	munmap(map_start, MAX_HEAP);
+    map_start = NULL;
+    memset(map_dirty, 0, sizeof(map_dirty));
 }
 
 /*
- * mem_reset_brk - reset the simulated brk pointer to make an empty heap
+ * mem_reset_brk - reset the simulated brk pointer to make an empty heap.
+ *    Every extra region is released as well.
  */
 void mem_reset_brk()
 {
-    mem_brk = mem_start_brk;
+    int r;
+
+    for (r = 0; r < region_count; r++) {
+	region_release(&regions[r], regions[r].start_brk);
+	regions[r].brk = regions[r].start_brk;
+	regions[r].peak_brk = regions[r].start_brk;
+    }
+    region_count = 1;
+    memset(map_used, 0, sizeof(map_used));
+    map_bytes = 0;
+    map_peak = 0;
+    footprint_peak = 0;
+}
+
+/*
+ * mem_region_new - start a new empty region and return its number,
+ *    or -1 if MEM_MAX_REGIONS are in use. Callers serialize calls.
+ */
+int mem_region_new(void)
+{
+    int r = region_count;
+
+    if (r >= MEM_MAX_REGIONS || region_alloc(r) < 0)
+	return -1;
+    __atomic_store_n(&region_count, r + 1, __ATOMIC_RELEASE);
+    return r;
+}
+
+/*
+ * mem_region_of - return the number of the region holding p, or -1
+ */
+int mem_region_of(const void *p)
+{
+    int n = __atomic_load_n(&region_count, __ATOMIC_ACQUIRE);
+    int r;
+
+    for (r = 0; r < n; r++) {
+	if ((const char *)p >= regions[r].start_brk && (const char *)p < regions[r].max_addr)
+	    return r;
+    }
+    return -1;
 }
 
 /* 
- * mem_sbrk - simple model of the sbrk function. Extends the heap 
- *    by incr bytes and returns the start address of the new area. In
- *    this model, the heap cannot be shrunk.
+ * mem_region_sbrk - simple model of the sbrk function. Extends region r
+ *    by incr bytes and returns the start address of the new area.
+ *    A negative incr releases -incr bytes from the top of the region
+ *    and returns the old brk, as sbrk does; with MEM_RELEASE its whole
+ *    pages read as zero again afterwards. Only the part of the new area at or above
+ *    mem_region_clean(r) is guaranteed to read as zero.
  */
-void *mem_sbrk(int incr) 
+void *mem_region_sbrk(int r, int incr)
 {
-    char *old_brk = mem_brk;
+    region_t *rg = &regions[r];
+    char *old_brk = rg->brk;
 
-    if ( (incr < 0) || ((mem_brk + incr) > mem_max_addr)) {
+    if (incr < 0 && (rg->brk + incr) < rg->start_brk) {
+	errno = EINVAL;
+	fprintf(stderr, "ERROR: mem_sbrk failed. Shrank below the heap start...\n");
+	return (void *)-1;
+    }
+    if ((rg->brk + incr) > rg->max_addr) {
 	errno = ENOMEM;
 	fprintf(stderr, "ERROR: mem_sbrk failed. Ran out of memory...\n");
 	return (void *)-1;
     }
-    mem_brk += incr;
+    if (old_brk + incr > rg->zero_brk)
+	rg->zero_brk = old_brk + incr;
+    else if (incr < 0)
+	region_release(rg, old_brk + incr);
+    __atomic_store_n(&rg->brk, old_brk + incr, __ATOMIC_RELAXED);
+    if (rg->brk > rg->peak_brk)
+	rg->peak_brk = rg->brk;
+    if (r == 0 && incr > 0)
+	footprint_note();
     return (void *)old_brk;
 }
 
+/*
+ * mem_region_lo - return address of the first byte of region r
+ */
+void *mem_region_lo(int r)
+{
+    return (void *)regions[r].start_brk;
+}
+
+/*
+ * mem_region_hi - return address of the last byte of region r
+ */
+void *mem_region_hi(int r)
+{
+    return (void *)(regions[r].brk - 1);
+}
+
+/*
+ * mem_region_clean - return the first byte of region r that has never
+ *    been handed out. It and every byte above it read as zero.
+ */
+void *mem_region_clean(int r)
+{
+    return (void *)regions[r].zero_brk;
+}
+
+/*
+ * mem_region_size - returns the size of region r in bytes
+ */
+size_t mem_region_size(int r)
+{
+    return (size_t)(regions[r].brk - regions[r].start_brk);
+}
+
+/* 
+ * mem_sbrk - mem_region_sbrk on region 0
+ */
+void *mem_sbrk(int incr) 
+{
+    return mem_region_sbrk(0, incr);
+}
+
 /*
  * mem_heap_lo - return address of the first heap byte
  */
 void *mem_heap_lo()
 {
-    return (void *)mem_start_brk;
+    return mem_region_lo(0);
 }
 
 /* 
@@ -81,7 +318,7 @@ void *mem_heap_lo()
  */
 void *mem_heap_hi()
 {
-    return (void *)(mem_brk - 1);
+    return mem_region_hi(0);
 }
 
 /*
@@ -89,7 +326,161 @@ void *mem_heap_hi()
  */
 size_t mem_heapsize() 
 {
-    return (size_t)(mem_brk - mem_start_brk);
+    return mem_region_size(0);
+}
+
+/*
+ * mem_heap_peak() - returns the largest heap size in bytes since the
+ *    last mem_init or mem_reset_brk
+ */
+size_t mem_heap_peak()
+{
+    return (size_t)(regions[0].peak_brk - regions[0].start_brk);
+}
+
+/*
+ * map_clear - zero the pages of [first, first + pages) that were mapped
+ *    before and mark them as used once. Called with map_lock held.
+ */
+static void map_clear(size_t first, size_t pages)
+{
+    size_t i;
+
+    for (i = first; i < first + pages; i++) {
+	if (map_dirty[i])
+	    memset(map_start + i * MEM_MAP_PAGE, 0, MEM_MAP_PAGE);
+	map_dirty[i] = 1;
+    }
+}
+
+/*
+ * mem_map - simple model of an anonymous mmap. Maps bytes (rounded up
+ *    to whole MEM_MAP_PAGE pages) at the lowest free run of pages and
+ *    returns its page-aligned start, or (void *)-1 if none is free.
+ *    The mapping reads as zero.
+ */
+void *mem_map(size_t bytes)
+{
+    size_t pages = (bytes + MEM_MAP_PAGE - 1) / MEM_MAP_PAGE;
+    size_t first, run;
+
+    if (pages == 0 || pages > MAP_PAGES) {
+	errno = EINVAL;
+	return (void *)-1;
+    }
+    pthread_mutex_lock(&map_lock);
+    for (first = 0, run = 0; first + run < MAP_PAGES && run < pages; ) {
+	if (map_used[first + run]) {
+	    first += run + 1;
+	    run = 0;
+	} else
+	    run++;
+    }
+    if (run < pages) {
+	pthread_mutex_unlock(&map_lock);
+	errno = ENOMEM;
+	fprintf(stderr, "ERROR: mem_map failed. Ran out of memory...\n");
+	return (void *)-1;
+    }
+    memset(map_used + first, 1, pages);
+    map_clear(first, pages);
+    __atomic_store_n(&map_bytes, map_bytes + pages * MEM_MAP_PAGE, __ATOMIC_RELAXED);
+    if (map_bytes > map_peak)
+	map_peak = map_bytes;
+    pthread_mutex_unlock(&map_lock);
+    footprint_note();
+    return map_start + first * MEM_MAP_PAGE;
+}
+
+/*
+ * mem_unmap - simple model of munmap. Releases the pages of
+ *    [p, p + bytes) at once; p must be page aligned.
+ */
+int mem_unmap(void *p, size_t bytes)
+{
+    size_t first = ((char *)p - map_start) / MEM_MAP_PAGE;
+    size_t pages = (bytes + MEM_MAP_PAGE - 1) / MEM_MAP_PAGE;
+
+    if (!mem_is_mapped(p) || ((char *)p - map_start) % MEM_MAP_PAGE != 0 || first + pages > MAP_PAGES) {
+	errno = EINVAL;
+	return -1;
+    }
+    pthread_mutex_lock(&map_lock);
+    memset(map_used + first, 0, pages);
+    __atomic_store_n(&map_bytes, map_bytes - pages * MEM_MAP_PAGE, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&map_lock);
+    return 0;
+}
+
+/*
+ * mem_remap - simple model of mremap without MREMAP_MAYMOVE. Resizes
+ *    the mapping at p from old_bytes to new_bytes in place: shrinking
+ *    always works, growing only if the following pages are free.
+ *    Returns p, or (void *)-1 if the mapping cannot grow in place.
+ */
+void *mem_remap(void *p, size_t old_bytes, size_t new_bytes)
+{
+    size_t first = ((char *)p - map_start) / MEM_MAP_PAGE;
+    size_t old_pages = (old_bytes + MEM_MAP_PAGE - 1) / MEM_MAP_PAGE;
+    size_t new_pages = (new_bytes + MEM_MAP_PAGE - 1) / MEM_MAP_PAGE;
+    size_t i;
+
+    if (new_pages == 0 || first + new_pages > MAP_PAGES)
+	return (void *)-1;
+    pthread_mutex_lock(&map_lock);
+    for (i = old_pages; i < new_pages; i++) {
+	if (map_used[first + i]) {
+	    pthread_mutex_unlock(&map_lock);
+	    return (void *)-1;
+	}
+    }
+    if (new_pages > old_pages) {
+	memset(map_used + first + old_pages, 1, new_pages - old_pages);
+	map_clear(first + old_pages, new_pages - old_pages);
+    } else
+	memset(map_used + first + new_pages, 0, old_pages - new_pages);
+    __atomic_store_n(&map_bytes, map_bytes + (new_pages - old_pages) * MEM_MAP_PAGE, __ATOMIC_RELAXED);
+    if (map_bytes > map_peak)
+	map_peak = map_bytes;
+    pthread_mutex_unlock(&map_lock);
+    if (new_pages > old_pages)
+	footprint_note();
+    return p;
+}
+
+/*
+ * mem_is_mapped - true if p lies in the mapping area (mapped or not)
+ */
+int mem_is_mapped(const void *p)
+{
+    return (const char *)p >= map_start && (const char *)p < map_start + MAX_HEAP;
+}
+
+/*
+ * mem_mapsize - returns the bytes currently mapped
+ */
+size_t mem_mapsize()
+{
+    return __atomic_load_n(&map_bytes, __ATOMIC_RELAXED);
+}
+
+/*
+ * mem_map_peak - returns the most bytes mapped at once since the
+ *    last mem_init or mem_reset_brk
+ */
+size_t mem_map_peak()
+{
+    return map_peak;
+}
+
+/*
+ * mem_footprint_peak - returns the largest region 0 heap size plus
+ *    mapped bytes at any one time since the last mem_init or
+ *    mem_reset_brk
+ */
+size_t mem_footprint_peak()
+{
+    return footprint_peak;
 }
 
 /*
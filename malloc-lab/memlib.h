@@ -1,6 +1,11 @@
 #include <unistd.h> 
 // 유닉스 시스템 호출(sbrk 등)을 사용하기 위한 헤더 파일
 
+// 익명 mmap 메모리라 한 번도 내준 적 없는 힙 바이트는 0이다. MEM_RELEASE(config.h)면 힙을 줄이거나 리셋할 때
+// 돌려준 페이지도 커널에 반납해 다시 0이 된다. 그 밖에 전에 쓰던 곳을 다시 내줄 때는 지우지 않는다
+// (시간 측정 루프 안에서 매번 memset하지 않도록). 0이 필요한 쪽(calloc)은 mem_region_clean 아래만 직접 지운다.
+// mem_map, mem_remap이 새로 내준 페이지는 진짜 mmap처럼 항상 0이다
+
 void mem_init(void); 
 // 가짜 힙을 초기화한다. (malloc 실습용으로 가상 메모리를 설정하는 함수)
 
@@ -10,6 +15,7 @@ void mem_deinit(void);
 void *mem_sbrk(int incr); 
 // 현재 가짜 힙을 'incr' 바이트만큼 확장하고, 
 // 확장하기 전의 힙 마지막 주소(old break pointer)를 리턴한다
+// incr이 음수면 힙 끝에서 -incr 바이트를 돌려준다 (힙 시작 아래로는 줄일 수 없음)
 // (진짜 시스템 콜 sbrk를 흉내낸 함수)
 
 void mem_reset_brk(void); 
@@ -28,6 +34,52 @@ size_t mem_heapsize(void);
 // 현재 가짜 힙의 총 크기를 바이트 단위로 리턴한다
 // (mem_heap_hi() - mem_heap_lo() 차이)
 
+size_t mem_heap_peak(void); 
+// 마지막 초기화(mem_init / mem_reset_brk) 이후 힙이 가장 컸을 때의 크기
+// (힙을 줄여도 이 값은 내려가지 않는다)
+
+// 여러 개의 독립된 가짜 힙(영역). 영역 0이 위의 mem_sbrk 등이 쓰는 힙이고,
+// 나머지는 할당기 아레나마다 하나씩 mem_region_new로 받는다. mem_reset_brk는 영역 0만 남긴다
+#define MEM_MAX_REGIONS 8
+
+int mem_region_new(void);
+// 빈 영역을 하나 새로 열고 번호를 리턴한다. 더 열 수 없으면 -1 (호출자가 직렬화해야 함)
+
+int mem_region_of(const void *p);
+// 주소 p가 들어 있는 영역 번호, 어느 영역에도 없으면 -1
+
+void *mem_region_sbrk(int r, int incr);
+void *mem_region_lo(int r);
+void *mem_region_hi(int r);
+size_t mem_region_size(int r);
+// 영역 r에 대한 mem_sbrk / mem_heap_lo / mem_heap_hi / mem_heapsize
+
+void *mem_region_clean(int r);
+// 영역 r에서 0이 보장되는 첫 바이트 (한 번도 내준 적 없거나 반납된 페이지). 여기부터 위는 모두 0 (힙 끝보다 아래일 수 없다)
+
+// mmap/munmap을 흉내낸 페이지 단위 매핑. sbrk 영역들과 따로 떨어진 MAX_HEAP 바이트 공간을
+// MEM_MAP_PAGE 페이지로 나눠 쓰고, 해제하면 그 페이지가 바로 돌아온다 (따로 집계)
+#define MEM_MAP_PAGE 4096
+
+void *mem_map(size_t bytes);
+// bytes를 페이지 단위로 올려 매핑하고 페이지 정렬된 시작 주소를 리턴한다. 실패하면 (void *)-1
+
+int mem_unmap(void *p, size_t bytes);
+// p부터 bytes만큼의 페이지를 바로 돌려준다. 0, 잘못된 주소면 -1
+
+void *mem_remap(void *p, size_t old_bytes, size_t new_bytes);
+// 매핑을 제자리에서 늘리거나 줄인다 (뒤 페이지가 비어 있어야 늘어남). p, 못 늘리면 (void *)-1
+
+int mem_is_mapped(const void *p);
+// 주소 p가 매핑 공간 안에 있으면 1
+
+size_t mem_mapsize(void);
+size_t mem_map_peak(void);
+// 지금 매핑된 바이트 / 마지막 초기화 이후 가장 많이 매핑됐을 때의 바이트
+
+size_t mem_footprint_peak(void);
+// 마지막 초기화 이후 (영역 0 힙 크기 + 매핑된 바이트)가 가장 컸을 때의 값 (드라이버 util의 분모)
+
 size_t mem_pagesize(void); 
 // 운영체제의 메모리 페이지 크기(바이트)를 리턴한다
 // (보통 4096바이트 = 4KB. 시스템에 따라 다를 수 있음)
\ No newline at end of file
@@ -1,21 +1,54 @@
-//묵시적 프리 리스트
-//넥스트 핏
-//헤더푸터크기 64비트 기준 wsize=8
-//최소블록크기 dsize=16
+//프리 리스트 = 묵시적(IMPLICIT) / 명시적(EXPLICIT) / 분리(SEGREGATED) / TLSF, 컴파일 시 -DFREE_LIST=... 로 선택 (기본 분리)
+//탐색 = 묵시적이면 넥스트 핏, 명시적이면 프리 리스트 퍼스트 핏, 분리면 요청 클래스부터 위로 올라가며 맞는 첫 클래스 안에서 베스트 핏
+//탐색 정책은 -DFIT_POLICY=FIRST_FIT/NEXT_FIT/BEST_FIT로 바꿀 수 있음 (넥스트 핏은 묵시적 리스트 전용, 베스트 핏은 맞는 첫 클래스 안에서 가장 작은 블록)
+//분리 리스트 클래스 = 512B 미만은 16B 간격 선형, 그 이상은 2의 거듭제곱 구간 (clz로 O(1) 계산)
+//비어 있지 않은 클래스는 64비트 비트맵으로 표시, 탐색 시 ctz로 다음 클래스로 바로 점프
+//TLSF = 2의 거듭제곱 구간(fl) x 16개 선형 구간(sl), 비트맵 두 단계로 요청을 올린 구간의 머리 블록을 바로 꺼냄 (malloc/free 상수 시간)
+//명시적 리스트 = 프리 블록 페이로드 앞쪽에 pred/succ 저장 (힙 기준 32비트 오프셋), 삽입 정책은 LIFO 또는 주소순(ADDR_ORDER)
+//큰 프리 블록(TREE_MIN_SIZE 이상, 기본 분리 64KiB / 명시적 1KiB)은 리스트 대신 크기순 트립에 넣어 O(log n) 베스트 핏 (BEST_FIT_TREE), 같은 크기는 노드 하나에 체인
+//헤더푸터크기 wsize=4 (헤더 값이 unsigned int라 4바이트면 충분, -DWSIZE=8로 예전 배치 가능)
+//푸터는 프리 블록에만 둔다. 헤더 비트1(PREV_ALLOC)에 앞 블록 할당 여부를 기록해서 할당 블록 푸터를 생략
+//정렬 dsize=16, 최소블록크기 = 헤더 + pred + succ + 푸터를 16으로 올림 (wsize=4면 16B), 할당 블록 오버헤드 = 헤더 한 워드
+//초기화 시 패딩 dsize-wsize 바이트를 두어 모든 페이로드가 16B 정렬되게 한다
 //초기화 = prologue(가짜 할당 블록) + epilogue(가짜 0바이트 할당 블록) + extend_heap(CHUNKSIZE)
-//힙 확장 extend_heap(words)
-//병합, 네가지 케이스 처리 후 last_fitp를 병합 결과로 갱신
-//분할, 남은 크기 >= 2*DSIZE(16B)일때만 스플릿 -> 너무 많은 조각이 생기지 않도록
-//realloc(재할당) = 기존 공간이 충분하면 그대로 사용하고, 뒷 블록이 프리이고 붙여서 공간이 충분해진다면 인플레이스 확장
+//힙 확장 extend_heap(words), 힙 끝 블록(wilderness)이 프리면 모자란 만큼만 늘림 (grow_heap)
+//힙 끝이 할당 블록이면 chunk_size만큼, chunk_size는 확장이 잦으면 두 배 뜸하면 절반 (CHUNKSIZE ~ CHUNK_MAX)
+//wilderness는 다른 프리 블록이 맞지 않을 때만 잘라 써서 크게 유지 (리스트 모드), 자를 때는 앞쪽부터
+//free 후 wilderness가 TRIM_THRESHOLD를 넘으면 TRIM_KEEP만 남기고 mem_sbrk(음수)로 힙을 줄임 (trim_heap)
+//병합, 네가지 케이스 처리 후 last_fitp를 병합 결과로 갱신 (넥스트 핏)
+//분할, 남은 크기 >= SPLIT_MIN(기본 최소 블록)일때만 스플릿 -> 너무 많은 조각이 생기지 않도록
+//배치 방향 = PLACE_SPLIT_SIZE(기본 64B) 이상은 프리 블록 뒤쪽 끝, 미만은 앞쪽 끝에서 잘라 작은/큰 블록이 섞이지 않게
+//소형 객체(<= 128B) = 페이지 정렬 4KiB 런(run)에서 슬롯 단위로 할당, 슬롯에는 헤더 없음 (SMALL_RUNS)
+//첫 런은 런 밖 소형 블록이 RUN_MIN_LIVE개 넘게 살아 있을 때만 연다 (한두 개뿐이면 일반 블록으로 줘서 런이 자라는 블록을 막지 않게)
+//런 = 페이지 맨 앞 디스크립터 + 한 크기 슬롯 배열, 빈 슬롯은 256비트 비트맵으로 관리
+//포인터가 런 슬롯인지는 힙 페이지별 비트맵(run_map)으로 O(1) 판별, 디스크립터는 포인터를 페이지 경계로 내림
+//큰 요청(>= MMAP_THRESHOLD, 기본 128KiB) = sbrk 힙 대신 memlib 페이지 매핑(mmap 흉내)으로, free하면 페이지를 바로 돌려줘 brk를 붙잡지 않음
+//정렬 할당(mm_memalign) = 정렬 위치가 들어가는 프리 블록을 찾아 앞 조각은 프리 블록으로 돌려주고 뒤 조각은 분할, 맞는 게 없으면 정렬 위치까지만 힙을 늘림
+//배치 할당/해제(mm_malloc_batch/mm_free_batch) = 같은 크기 n개를 한 프리 블록(런 크기면 한 런)에서 연달아 잘라 주고, 해제는 주소순 정렬 후 붙어 있는 블록끼리 헤더 하나로 묶어 병합 한 번
+//calloc = memlib이 한 번도 내준 적 없는 힙(mem_region_clean 위)과 새 매핑은 이미 0이라, 힙 끝을 늘려 받은 블록은 그 경계 아래와 프리 블록 메타데이터 자리만 지움 (재활용 블록은 16B 정렬 SSE2 저장으로 통째로)
+//지연 병합(QUICK_LISTS) = 작은 블록은 free 시 병합하지 않고 정확한 크기별 LIFO 퀵 리스트에 보관 (헤더는 할당 상태 유지)
+//퀵 리스트는 fit 실패 시, 쌓인 바이트가 힙의 1/QUICK_FRAG_DIV를 넘거나 런 밖의 할당 바이트보다 많아지면 한꺼번에 병합(consolidate), 힙 끝을 막지 않게 해 trim이 돈다
+//스레드 안전 모드(THREAD_SAFE) = 공용 힙은 뮤텍스 하나, 스레드마다 512B 이하 블록 캐시를 두고 미스/넘침 때만 8개씩 묶어 락을 잡음
+//아레나 모드(ARENAS) = 스레드마다 memlib 영역(독립된 시뮬레이션 힙) 하나에 아레나를 따로 두고 락도 아레나별, free는 포인터가 속한 영역의 아레나로
+//원격 해제(REMOTE_FREE) = 남의 아레나 블록 free는 주인 아레나의 락 없는 MPSC 스택에 얹고, 주인이 다음 malloc 때 락 한 번에 몰아서 해제
+//코어별 캐시(PERCPU_CACHE) = 스레드 캐시 대신 CPU마다 클래스별 캐시, rseq 구간 안에서 커밋 저장 한 번으로 push/pop (캐시 메모리가 스레드 수가 아니라 코어 수에 비례)
+//realloc(재할당) = 줄이는 요청은 남는 꼬리가 최소 블록 이상이면 떼어 뒤 프리 블록과 병합 (제자리 축소), 쓸 수 있는 실제 크기는 mm_usable_size로
+//늘리는 요청은 블록(또는 예약분) 안에 들어가면 그대로 사용하고, 뒷 블록이 프리이고 붙여서 공간이 충분해진다면 인플레이스 확장
+//힙 끝 블록이면 모자란 만큼만 힙을 늘려 제자리 확장, 아니고 앞 블록이 프리면 흡수하고 memmove 한 번으로 당김
+//두 번 이상 커진 블록이 옮겨야 하면 맞는 프리 블록 앞쪽으로, 없으면 wilderness로 보내 힙을 늘림 (예약 없이)
+//MMAP_THRESHOLD 이상으로 자라면 뒤 프리 블록으로 충분할 때만 제자리, 아니면 힙을 늘리지 않고 매핑으로 옮겨 이후엔 mem_remap으로 자라게 함
+//확장 후 남는 꼬리는 떼어서 프리 블록으로 돌려줌
 //그 외에는 new malloc + memcpy + free
+//계속 자라는 블록(두 번째 위로 realloc부터)은 asize의 절반을 꼬리에 예약 (REALLOC_RESERVE), 다른 할당은 압박 시에만 거둬감
 
 //적용한 최적화 요약 = 
-    //블록관리 = 묵시적
-    //탐색 = 넥스트핏
-    //크기 = 64바이트 헤더푸터터
+    //블록관리 = 묵시적 / 명시적(이중 연결 프리 리스트)
+    //탐색 = 넥스트핏 / 프리 블록만 순회하는 퍼스트핏 / 크기 클래스별 분리 리스트
+    //크기 = 4바이트 헤더푸터, 할당 블록은 푸터 생략
     //블록 분할/병합 정책 다듬기
+    //소형 요청은 런 슬롯 (블록당 오버헤드 0, 런 단위로 페이지 정렬 블록을 힙에서 잘라옴)
     //realloc in-place 확률 늘리기
-    //즉시 병합 + 4KiB단위 힙 하ㅗㄱ장
+    //즉시 병합 + 4KiB단위 힙 하ㅗㄱ장, 작은 블록은 퀵 리스트로 병합 지연
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -25,27 +58,426 @@
 
 #include "mm.h"
 #include "memlib.h"
+#include "config.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifndef WSIZE
+#define WSIZE 4         // 헤더/푸터 한 개 크기
+#endif
+#define DSIZE 16        // 페이로드 정렬 단위
+#define CHUNKSIZE (1<<12)   // 첫 확장 크기이자 적응형 확장 크기의 하한
+#ifndef CHUNK_MAX
+#define CHUNK_MAX (1<<14)
+#endif
+// 확장 간격이 GROW_BURST번 malloc 미만인 확장이 GROW_STREAK번 이어지면 힙이 빠르게 자라는 중으로 본다
+#ifndef GROW_BURST
+#define GROW_BURST 32
+#endif
+#ifndef GROW_STREAK
+#define GROW_STREAK 4
+#endif
+// wilderness가 TRIM_THRESHOLD를 넘으면 TRIM_KEEP만 남기고 힙 끝을 돌려준다 (0 = 줄이지 않음)
+#ifndef TRIM_THRESHOLD
+#define TRIM_THRESHOLD (1<<16)
+#endif
+#define TRIM_KEEP CHUNKSIZE
+
+// 스레드 안전 모드 (아래 스레드 캐시 참고). 캐시가 락 없이 헤더와 런 맵을 읽으므로
+// 그 워드들은 원자적으로 읽고 쓴다 (relaxed, x86에서는 일반 mov와 같다)
+// 아레나 모드(ARENAS)는 스레드마다 memlib 영역 하나짜리 힙을 따로 주고, 스레드 안전 모드를 켠다
+// 원격 해제(REMOTE_FREE)는 다른 아레나 블록의 free를 락 없이 주인 아레나의 스택에 얹는다 (아레나 모드를 켬)
+#ifndef REMOTE_FREE
+#define REMOTE_FREE 0
+#endif
+#ifndef ARENAS
+#define ARENAS REMOTE_FREE
+#endif
+#if REMOTE_FREE && !ARENAS
+#error "REMOTE_FREE needs ARENAS"
+#endif
+// 코어별 캐시(PERCPU_CACHE)는 스레드 캐시 대신 CPU마다 캐시를 두고 rseq 구간으로 락과 원자 연산 없이 고친다 (스레드 안전 모드를 켬)
+#ifndef PERCPU_CACHE
+#define PERCPU_CACHE 0
+#endif
+#ifndef THREAD_SAFE
+#define THREAD_SAFE (ARENAS || PERCPU_CACHE)
+#endif
+#if ARENAS && !THREAD_SAFE
+#error "ARENAS needs THREAD_SAFE"
+#endif
+#if PERCPU_CACHE && (!THREAD_SAFE || REMOTE_FREE)
+#error "PERCPU_CACHE needs THREAD_SAFE and does not combine with REMOTE_FREE"
+#endif
+// rseq 구간은 x86-64 리눅스(glibc 2.35 이상이 스레드마다 등록)에서만, 그 밖에는 항상 락 경로
+#if PERCPU_CACHE && defined(__x86_64__) && defined(__linux__) && __has_include(<sys/rseq.h>)
+#include <sys/rseq.h>
+#define HAVE_RSEQ 1
+#else
+#define HAVE_RSEQ 0
+#endif
+#define ARENA_COUNT (ARENAS ? MEM_MAX_REGIONS : 1)
+#if THREAD_SAFE
+#include <pthread.h>
+#define LOAD_WORD(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+#define STORE_WORD(p, v) __atomic_store_n(p, v, __ATOMIC_RELAXED)
+#define COUNTER_ADD(field, n) __atomic_fetch_add(&mm_counters.field, n, __ATOMIC_RELAXED)   // 아레나마다 락이 달라서
+#else
+#define LOAD_WORD(p) (*(p))
+#define STORE_WORD(p, v) (*(p) = (v))
+#define COUNTER_ADD(field, n) (mm_counters.field += (n))
+#endif
 
-#define WSIZE 8
-#define DSIZE 16
-#define CHUNKSIZE (1<<12)
 #define PACK(size, alloc) ((size) | (alloc))
-#define GET(p) (*(unsigned int *)(p))
-#define PUT(p, val) (*(unsigned int *)(p) = (val))
-#define GET_SIZE(p) (GET(p) & ~0x7)
+#define GET(p) LOAD_WORD((unsigned int *)(p))
+#define PUT(p, val) STORE_WORD((unsigned int *)(p), (val))
+#define GET_SIZE(p) (GET(p) & ~0xF)   // 블록 크기는 DSIZE 배수라 하위 4비트는 플래그
 #define GET_ALLOC(p) (GET(p) & 0x1)
+#define GET_FLAGS(p) (GET(p) & 0xF)
+#define PREV_ALLOC 0x2   // 헤더 비트1: 앞 블록이 할당 상태
+#define RESERVED 0x4     // 헤더 비트2: 할당 블록 꼬리에 realloc 여유분이 예약돼 있음
+#define GROWN 0x8        // 헤더 비트3: realloc으로 커진 적이 있는 할당 블록
+#define GET_PREV_ALLOC(p) (GET(p) & PREV_ALLOC)
+#define SET_PREV_ALLOC(p) PUT(p, GET(p) | PREV_ALLOC)
+#define CLEAR_PREV_ALLOC(p) PUT(p, GET(p) & ~PREV_ALLOC)
 #define HDRP(bp) ((char *)(bp) - WSIZE)
-#define FTRP(bp) ((char *)(bp) + GET_SIZE(HDRP(bp)) - DSIZE)
+#define FTRP(bp) ((char *)(bp) + GET_SIZE(HDRP(bp)) - 2 * WSIZE)   // 프리 블록에만 유효
 #define NEXT_BLKP(bp) ((char *)(bp) + GET_SIZE(((char *)(bp) - WSIZE)))
-#define PREV_BLKP(bp) ((char *)(bp) - GET_SIZE(((char *)(bp) - DSIZE)))
+#define PREV_BLKP(bp) ((char *)(bp) - GET_SIZE(((char *)(bp) - 2 * WSIZE)))   // 앞 블록이 프리일 때만 유효
+#define MIN_BLOCK ((4 * WSIZE + (DSIZE - 1)) & ~(DSIZE - 1))   // 헤더 + pred + succ + 푸터
+#define EPILOGUE_BP() ((char *)HEAP_HI() + 1)   // 에필로그 헤더는 힙 마지막 워드
+
+// 프리 리스트 구성 방식
+#define IMPLICIT 0      // 모든 블록을 헤더로 건너뛰며 탐색
+#define EXPLICIT 1      // 프리 블록끼리만 pred/succ로 연결
+#define SEGREGATED 2    // 크기 클래스마다 명시적 리스트를 따로 둔다
+#define TLSF 3          // 2단계 분리 리스트 (2의 거듭제곱 구간 x 선형 세분), 모든 연산 상수 시간
+
+// 명시적 리스트 삽입 정책
+#define LIFO 0          // 해제된 블록을 리스트 맨 앞에 (삽입 O(1))
+#define ADDR_ORDER 1    // 주소 오름차순 유지 (삽입 O(프리 블록 수), 단편화 적음)
+
+#ifndef FREE_LIST
+#define FREE_LIST SEGREGATED
+#endif
+#ifndef INSERT_POLICY
+#define INSERT_POLICY LIFO
+#endif
+
+// 탐색 정책. 기본은 묵시적 리스트면 넥스트 핏, 분리 리스트면 클래스 안 베스트 핏, 나머지는 퍼스트 핏. TLSF는 구간 올림 탐색이라 따로 고르지 않는다
+#define FIRST_FIT 0     // 앞에서부터 처음 맞는 블록
+#define NEXT_FIT 1      // 지난번 찾은 자리(last_fitp)부터 이어서
+#define BEST_FIT 2      // 맞는 블록 중 가장 작은 것 (정확히 맞으면 바로 멈춤)
+
+#ifndef FIT_POLICY
+#if FREE_LIST == IMPLICIT
+#define FIT_POLICY NEXT_FIT
+#elif FREE_LIST == SEGREGATED
+#define FIT_POLICY BEST_FIT
+#else
+#define FIT_POLICY FIRST_FIT
+#endif
+#endif
+#if FIT_POLICY == NEXT_FIT && FREE_LIST != IMPLICIT
+#error "NEXT_FIT needs FREE_LIST=IMPLICIT"
+#endif
+
+// 분할 기준: 자르고 남는 조각이 SPLIT_MIN 바이트 미만이면 블록을 통째로 준다 (최소 블록보다 작게는 못 자름)
+#ifndef SPLIT_MIN
+#define SPLIT_MIN MIN_BLOCK
+#endif
+#define SPLIT_THRESHOLD (SPLIT_MIN > MIN_BLOCK ? SPLIT_MIN : MIN_BLOCK)
+
+// 프리 블록 페이로드 앞 두 워드에 저장하는 이전/다음 프리 블록.
+// 포인터 대신 heap_listp 기준 32비트 오프셋으로 저장해서 4바이트 워드에도 들어간다 (0 = NULL)
+#define LINK_OFF(p) ((p) != NULL ? (unsigned int)((char *)(p) - heap_listp) : 0)
+#define LINK_PTR(off) ((off) != 0 ? heap_listp + (off) : NULL)
+#define GET_PRED(bp) LINK_PTR(GET(bp))
+#define GET_SUCC(bp) LINK_PTR(GET((char *)(bp) + WSIZE))
+#define SET_PRED(bp, p) PUT(bp, LINK_OFF(p))
+#define SET_SUCC(bp, p) PUT((char *)(bp) + WSIZE, LINK_OFF(p))
+
+// 분리 리스트 크기 클래스: SMALL_CLASS_LIMIT 미만은 DSIZE 간격 한 크기씩,
+// 그 이상은 [2^k, 2^(k+1)) 구간 하나씩. 블록 크기는 unsigned int 헤더에 들어가므로 2^32 미만
+#define SMALL_CLASS_SHIFT 9
+#define SMALL_CLASS_LIMIT (1 << SMALL_CLASS_SHIFT)
+#define SMALL_CLASSES ((SMALL_CLASS_LIMIT - MIN_BLOCK) / DSIZE)
+#define LOG2(x) ((int)(sizeof(unsigned long) * 8 - 1) - __builtin_clzl(x))
+
+#if FREE_LIST == SEGREGATED
+#define LIST_COUNT (SMALL_CLASSES + 32 - SMALL_CLASS_SHIFT)
+#else
+#define LIST_COUNT 1
+#endif
+
+#if LIST_COUNT > 64
+#error "class_bitmap holds at most 64 size classes"
+#endif
+
+// TLSF: 1단계 fl = 2의 거듭제곱 구간, 2단계 sl = 그 구간을 TLSF_SL_COUNT개로 나눈 선형 구간.
+// 2^TLSF_LINEAR_SHIFT 미만은 fl 0 하나에 DSIZE 간격으로 담는다. 1단계 비트맵은 class_bitmap을 그대로 쓴다
+#ifndef TLSF_SL_LOG2
+#define TLSF_SL_LOG2 4
+#endif
+#define TLSF_SL_COUNT (1 << TLSF_SL_LOG2)
+#define TLSF_LINEAR_SHIFT (TLSF_SL_LOG2 + 4)   // DSIZE = 2^4
+#define TLSF_FL_COUNT (32 - TLSF_LINEAR_SHIFT + 1)
+
+#if TLSF_SL_LOG2 > 5
+#error "sl_bitmap holds at most 32 second-level lists"
+#endif
+
+// TLSF는 malloc/free 최악 시간을 상수로 묶는 게 목적이라 한꺼번에 도는 작업(퀵 리스트 병합, 예약 회수)은 기본으로 끄고
+// O(log n) 트리는 쓰지 않는다. 삽입은 항상 LIFO
+#if FREE_LIST == TLSF
+#ifndef QUICK_LISTS
+#define QUICK_LISTS 0
+#endif
+#ifndef REALLOC_RESERVE
+#define REALLOC_RESERVE 0
+#endif
+#undef BEST_FIT_TREE
+#define BEST_FIT_TREE 0
+#endif
 
-static char *heap_listp = 0;
-static char *last_fitp = NULL;
+// 큰 프리 블록 베스트 핏 트리 (리스트 모드): TREE_MIN_SIZE 이상 프리 블록은 크기순 트립(treap)에 넣는다.
+// 노드는 프리 페이로드에 left, right, 같은 크기 체인 next/prev, 우선순위 다섯 워드 (오프셋 링크).
+// 같은 크기 블록은 노드 하나에 체인으로 매달고, 체인 원소는 prev가 NULL이 아닌 것으로 노드와 구분한다.
+// 분리 리스트는 클래스 안 베스트 핏으로도 같은 이용률이 나오므로 클래스 구간이 넓은 64KiB 이상만 트리에 넣는다
+// (1KiB부터 넣으면 wilderness를 포함한 블록마다 회전이 일어나 random 처리량이 1/4로 떨어짐)
+#ifndef BEST_FIT_TREE
+#define BEST_FIT_TREE 1
+#endif
+#ifndef TREE_MIN_SIZE
+#if FREE_LIST == SEGREGATED
+#define TREE_MIN_SIZE 65536
+#else
+#define TREE_MIN_SIZE 1024
+#endif
+#endif
+#define T_LEFT(bp) LINK_PTR(GET(bp))
+#define T_RIGHT(bp) LINK_PTR(GET((char *)(bp) + WSIZE))
+#define T_NEXT(bp) LINK_PTR(GET((char *)(bp) + 2 * WSIZE))
+#define T_PREV(bp) LINK_PTR(GET((char *)(bp) + 3 * WSIZE))
+#define T_PRIO(bp) GET((char *)(bp) + 4 * WSIZE)
+#define SET_T_LEFT(bp, p) PUT(bp, LINK_OFF(p))
+#define SET_T_RIGHT(bp, p) PUT((char *)(bp) + WSIZE, LINK_OFF(p))
+#define SET_T_NEXT(bp, p) PUT((char *)(bp) + 2 * WSIZE, LINK_OFF(p))
+#define SET_T_PREV(bp, p) PUT((char *)(bp) + 3 * WSIZE, LINK_OFF(p))
+#define SET_T_PRIO(bp, v) PUT((char *)(bp) + 4 * WSIZE, v)
+#define IN_TREE(size) (BEST_FIT_TREE && FREE_LIST != IMPLICIT && (size) >= TREE_MIN_SIZE)
+
+// 소형 객체 런: RUN_MAX_SIZE 이하 요청은 RUN_SIZE짜리 페이지 정렬 블록을 슬롯으로 나눠 쓴다
+#ifndef SMALL_RUNS
+#define SMALL_RUNS 1
+#endif
+#define RUN_SIZE 4096
+#define RUN_MAX_SIZE 128
+#define RUN_CLASSES (RUN_MAX_SIZE / DSIZE)          // 슬롯 크기 16, 32, ..., 128
+#define RUN_BITMAP_WORDS 4                          // 최대 256 슬롯
+#define RUN_MAP_WORDS (MAX_HEAP / RUN_SIZE / 64 + 1)
+#define RUN_MIN_LIVE 32                             // 런 밖 소형 블록이 이만큼 살아 있어야 첫 런을 연다
+
+// 런 페이지 맨 앞에 놓이는 디스크립터. 슬롯은 RUN_HDR_SIZE 뒤부터 시작
+typedef struct run_t {
+    struct run_t *next;         // 빈 슬롯이 남은 같은 클래스 런끼리 연결
+    struct run_t *prev;
+    unsigned int slot_size;
+    unsigned int nslots;
+    unsigned int nfree;
+    unsigned int cls;
+    unsigned long free_bits[RUN_BITMAP_WORDS];  // 1 = 빈 슬롯
+} run_t;
+
+#define RUN_HDR_SIZE ((sizeof(run_t) + (DSIZE - 1)) & ~(DSIZE - 1))
+#define RUN_OF(p) ((run_t *)((unsigned long)(p) & ~(unsigned long)(RUN_SIZE - 1)))
+// 힙 시작은 페이지 경계가 아닐 수 있으므로 절대 주소의 페이지 번호 차이로 계산
+#define RUN_PAGE(p) ((unsigned long)(p) / RUN_SIZE - (unsigned long)(heap_listp - DSIZE) / RUN_SIZE)
+#define IS_RUN_SLOT(p) ((run_map[RUN_PAGE(p) / 64] >> (RUN_PAGE(p) % 64)) & 1)
+
+// 지연 병합 퀵 리스트: QUICK_MAX_SIZE 이하 블록은 크기별(DSIZE 간격) 단일 연결 리스트에 그대로 보관
+#ifndef QUICK_LISTS
+#define QUICK_LISTS 1
+#endif
+#define QUICK_MAX_SIZE 512
+#define QUICK_COUNT (QUICK_MAX_SIZE / DSIZE + 1)
+#define QUICK_FRAG_DIV 8     // 퀵 리스트 바이트가 힙의 1/8을 넘으면 병합
+#define QUICK_NEXT(bp) LINK_PTR(GET(bp))
+#define SET_QUICK_NEXT(bp, p) PUT(bp, LINK_OFF(p))
+
+// 스레드 안전 모드: 지금까지의 할당기 전체를 공용 힙으로 두고 뮤텍스 하나로 감싼다.
+// 스레드마다 작은 블록 캐시(클래스별 단일 연결 리스트)를 두어 대부분의 malloc/free는 락 없이 끝내고,
+// 미스나 넘침은 TCACHE_BATCH개씩 묶어 락 한 번으로 공용 힙과 주고받는다
+#define TCACHE_MAX_SIZE 512     // 이 크기 이하 블록만 캐시
+#define TCACHE_BATCH 8
+#define TCACHE_LIMIT 32         // 클래스별 최대 보관 개수, 넘으면 TCACHE_BATCH개를 공용 힙에 돌려줌
+#define TCACHE_BLOCK_CLASSES (TCACHE_MAX_SIZE / DSIZE + 1)
+#define TCACHE_CLASSES (TCACHE_BLOCK_CLASSES + RUN_CLASSES)
+#define TC_NEXT(bp) (*(char **)(bp))
+#define PERCPU_MAX_CPUS 64      // 이 번호 이상 CPU에서는 캐시 없이 락 경로
+#define REMOTE_DRAIN_LIMIT 64   // 원격 해제 스택이 이만큼 쌓이면 얹는 스레드가 (락이 비어 있을 때) 대신 비움
+
+// place 방향 기준 크기 (바이트, 0 = 항상 앞쪽에서 자름)
+#ifndef PLACE_SPLIT_SIZE
+#define PLACE_SPLIT_SIZE 64
+#endif
+
+// 이 크기 이상 요청은 sbrk 힙 대신 memlib 매핑(mem_map)에서 따로 받고, free하면 페이지째 바로 돌려준다 (0 = 끔).
+// 매핑 블록 = 페이지 정렬 시작 + DSIZE 뒤 페이로드, 바로 앞 헤더에 매핑 길이 (할당 비트 1).
+// 정렬 요청은 페이로드를 시작 + align에 둔다 (align <= MEM_MAP_PAGE라 시작은 페이로드 - DSIZE를 페이지로 내린 곳)
+#ifndef MMAP_THRESHOLD
+#define MMAP_THRESHOLD (128 * 1024)
+#endif
+#define MAP_LEN(off, size) (((off) + (size) + MEM_MAP_PAGE - 1) & ~(size_t)(MEM_MAP_PAGE - 1))
+#define MAP_BASE(ptr) ((char *)(((unsigned long)(ptr) - DSIZE) & ~(unsigned long)(MEM_MAP_PAGE - 1)))
+#define IS_MAPPED(ptr) (MMAP_THRESHOLD > 0 && mem_is_mapped(ptr))
+
+// 배치가 이보다 작으면 통째 fit, 압박 해소, 정렬을 건너뛰고 블록마다 heap_malloc/heap_free를 부른다 (런 크기 할당은 제외)
+#define BATCH_MIN 2
+
+// calloc: 프리 블록이 페이로드 앞쪽에 쓰는 메타데이터의 최대 크기 (트립 노드 다섯 워드).
+// 힙을 늘려 받은 블록도 옛 힙 끝에서 이만큼까지는 링크가 쓰였을 수 있어서 지운다
+#define FREE_META_SIZE (5 * WSIZE)
+#define ZERO_FILL_VEC_MAX 512   // 이 크기 이하는 16B 저장 루프로, 넘으면 memset으로 지운다
+
+// realloc 여유분 예약: 계속 자라는 블록은 실제 필요 크기보다 크게 잡고, 꼬리를 예약 리스트에 올린다.
+// 예약분은 블록 안에 있으므로 다른 할당은 못 쓰고, fit 실패(압박) 시 trim_reserves가 떼어 돌려준다.
+// 예약 기록(pred, succ, 실제 블록 크기 세 워드)은 블록 끝 MIN_BLOCK 영역에 둔다
+#ifndef REALLOC_RESERVE
+#define REALLOC_RESERVE 1
+#endif
+#define RESERVE_SIZE(asize) (((asize) / 2 + (DSIZE - 1)) & ~(DSIZE - 1))
+#define RSV_REC(bp) ((char *)(bp) + GET_SIZE(HDRP(bp)) - WSIZE - MIN_BLOCK)
+
+// 힙 하나의 할당기 상태 전부. 아레나 모드가 아니면 arenas[0] 하나만 쓰고,
+// 아래 매크로로 예전 전역 변수 이름 그대로 현재 아레나(AR)의 필드를 가리킨다
+typedef struct {
+    char *heap_listp;
+#if FREE_LIST == IMPLICIT
+#if FIT_POLICY == NEXT_FIT
+    char *last_fitp;
+#endif
+#elif FREE_LIST == TLSF
+    char *free_lists[TLSF_FL_COUNT][TLSF_SL_COUNT];
+    unsigned int sl_bitmap[TLSF_FL_COUNT];   // j번 비트 = free_lists[i][j]가 비어 있지 않음
+    unsigned long class_bitmap;              // i번 비트 = sl_bitmap[i]가 0이 아님
+#else
+    char *free_lists[LIST_COUNT];   // 클래스별 리스트 머리
+    unsigned long class_bitmap;     // i번 비트 = free_lists[i]가 비어 있지 않음
+#if BEST_FIT_TREE
+    char *tree_root;                // TREE_MIN_SIZE 이상 프리 블록 트립
+#endif
+#endif
+#if SMALL_RUNS
+    run_t *run_lists[RUN_CLASSES];          // 클래스별로 빈 슬롯이 남은 런
+    unsigned long run_map[RUN_MAP_WORDS];   // 힙 페이지별 1 = 런 페이지
+    size_t run_bytes;                       // 런 블록 바이트 합
+    size_t small_live;                      // 런 밖에서 준 소형 블록 중 아직 할당된 수 (근삿값)
+#endif
+#if QUICK_LISTS
+    char *quick_lists[QUICK_COUNT];   // quick_lists[asize / DSIZE]
+    size_t quick_bytes;               // 퀵 리스트에 묶인 바이트 합
+#endif
+#if REALLOC_RESERVE
+    char *reserve_listp;              // 꼬리를 예약 중인 할당 블록들
+#endif
+    size_t chunk_size;                // 힙 끝이 할당 블록일 때 한 번에 늘리는 크기
+    size_t free_bytes;                // 프리 리스트(와 트리)에 든 블록 바이트 합
+    unsigned long mallocs_since_grow;
+    int grow_streak;                  // 연달아 GROW_BURST 안에 일어난 확장 횟수
+    int region;                       // 이 아레나의 힙인 memlib 영역 번호
+#if THREAD_SAFE
+    pthread_mutex_t lock;
+#endif
+#if REMOTE_FREE
+    char *remote_head;                // 다른 스레드가 해제한 블록 스택 (TC_NEXT로 연결, CAS로 push)
+    unsigned int remote_count;        // 스택에 쌓인 대략의 개수
+#endif
+} arena_t;
+
+static arena_t arenas[ARENA_COUNT];
+#if ARENAS
+static __thread arena_t *cur_arena = &arenas[0];   // 이 스레드가 지금 다루는 아레나 (락을 잡고 바꾼다)
+#define AR cur_arena
+#else
+#define AR (&arenas[0])
+#endif
+
+#define heap_listp (AR->heap_listp)
+#define last_fitp (AR->last_fitp)
+#define free_lists (AR->free_lists)
+#define sl_bitmap (AR->sl_bitmap)
+#define class_bitmap (AR->class_bitmap)
+#define tree_root (AR->tree_root)
+#define run_lists (AR->run_lists)
+#define run_map (AR->run_map)
+#define run_bytes (AR->run_bytes)
+#define small_live (AR->small_live)
+#define quick_lists (AR->quick_lists)
+#define quick_bytes (AR->quick_bytes)
+#define reserve_listp (AR->reserve_listp)
+#define chunk_size (AR->chunk_size)
+#define mallocs_since_grow (AR->mallocs_since_grow)
+#define grow_streak (AR->grow_streak)
+#define free_bytes (AR->free_bytes)
+
+// 현재 아레나의 memlib 영역
+#define HEAP_SBRK(incr) mem_region_sbrk(AR->region, incr)
+#define HEAP_HI() mem_region_hi(AR->region)
+#define HEAP_CLEAN() mem_region_clean(AR->region)
+#define HEAP_SIZE() mem_region_size(AR->region)
+
+mm_counters_t mm_counters;
+const int mm_thread_safe = THREAD_SAFE;
 
 static void *extend_heap(size_t words);
+static void *grow_heap(size_t need);
+static char *wild_block(void);
+static void *wild_alloc(size_t asize);
+static void trim_heap(void);
 static void *coalesce(void *bp);
 static void *find_fit(size_t asize);
-static void place(void *bp, size_t asize);
+static void *place(void *bp, size_t asize);
+static void place_low(void *bp, size_t asize);
+static void insert_free(void *bp);
+static void remove_free(void *bp);
+static size_t adjust_size(size_t size);
+static void free_block(void *bp);
+static void split_tail(void *bp, size_t asize);
+static int relieve_pressure(void);
+static void *map_alloc(size_t align, size_t size);
+static void map_free(void *ptr);
+static void *map_realloc(void *ptr, size_t size);
+static int heap_init(void);
+static void *heap_malloc(size_t size);
+static void heap_free(void *ptr);
+static void *heap_realloc(void *ptr, size_t size);
+static void *heap_calloc(size_t size);
+static void *heap_memalign(size_t align, size_t size);
+static size_t heap_usable_size(void *ptr);
+static size_t heap_malloc_batch(void **ptrs, size_t n, size_t size);
+static void heap_free_batch(void **ptrs, size_t n);
+static size_t carve_blocks(char *bp, size_t asize, size_t n, void **ptrs);
+static void sort_ptrs(void **ptrs, size_t n);
+static void zero_fill(void *bp, size_t n);
+#if QUICK_LISTS
+static int consolidate(void);
+#endif
+#if REALLOC_RESERVE
+static void reserve(void *bp, size_t asize);
+static void unreserve(void *bp);
+static int trim_reserves(void);
+#endif
+static void *alloc_aligned(size_t align, size_t asize);
+#if SMALL_RUNS
+static int use_run(size_t size, size_t n);
+static void *run_alloc(size_t size);
+static size_t run_alloc_batch(void **ptrs, size_t n, size_t size);
+static void run_free(void *ptr);
+static void release_run(run_t *run);
+#endif
 
 team_t team = {
     "KRAFTON JUNGLE 8th 301",
@@ -55,176 +487,680 @@ team_t team = {
     ""
 };
 
-#define ALIGNMENT 8
-#define ALIGN(size) (((size) + (ALIGNMENT - 1)) & ~0x7)
-#define SIZE_T_SIZE (ALIGN(sizeof(size_t)))
-
-int mm_init(void) {
-    // printf("[DEBUG] mm_init() 시작\n");
+static int heap_init(void) {
+    // printf("[DEBUG] heap_init() 시작\n");
 
-    if ((heap_listp = mem_sbrk(4 * WSIZE)) == (void *)-1) {
-        // printf("[DEBUG] mem_sbrk(4*WSIZE) 실패\n");
+    if ((heap_listp = HEAP_SBRK(2 * DSIZE)) == (void *)-1) {
+        // printf("[DEBUG] mem_sbrk(2*DSIZE) 실패\n");
         return -1;
     }
 
-    PUT(heap_listp, 0);
-    PUT(heap_listp + (1 * WSIZE), PACK(DSIZE, 1));
-    PUT(heap_listp + (2 * WSIZE), PACK(DSIZE, 1));
-    PUT(heap_listp + (3 * WSIZE), PACK(0, 1));
-    heap_listp += (2 * WSIZE);
+    // 패딩(DSIZE - WSIZE) | 프롤로그 헤더 | 프롤로그 본문 | 에필로그 헤더
+    // 프롤로그 페이로드가 DSIZE 경계에 오므로 이후 모든 페이로드도 DSIZE 정렬
+    memset(heap_listp, 0, DSIZE - WSIZE);
+    heap_listp += DSIZE;
+    PUT(HDRP(heap_listp), PACK(DSIZE, 1 | PREV_ALLOC));
+    PUT(HDRP(NEXT_BLKP(heap_listp)), PACK(0, 1 | PREV_ALLOC));
 
+#if FREE_LIST == IMPLICIT
+#if FIT_POLICY == NEXT_FIT
     last_fitp = NEXT_BLKP(heap_listp);
+#endif
+#else
+    memset(free_lists, 0, sizeof(free_lists));
+    class_bitmap = 0;
+#if FREE_LIST == TLSF
+    memset(sl_bitmap, 0, sizeof(sl_bitmap));
+#endif
+#if BEST_FIT_TREE
+    tree_root = NULL;
+#endif
+#endif
+#if SMALL_RUNS
+    memset(run_lists, 0, sizeof(run_lists));
+    memset(run_map, 0, sizeof(run_map));
+    run_bytes = 0;
+    small_live = 0;
+#endif
+#if QUICK_LISTS
+    memset(quick_lists, 0, sizeof(quick_lists));
+    quick_bytes = 0;
+#endif
+#if REALLOC_RESERVE
+    reserve_listp = NULL;
+#endif
+    chunk_size = CHUNKSIZE;
+    free_bytes = 0;
+    mallocs_since_grow = GROW_BURST;   // 초기 확장은 급증으로 치지 않는다
+    grow_streak = 0;
 
     if (extend_heap(CHUNKSIZE / WSIZE) == NULL) {
         // printf("[DEBUG] extend_heap 실패\n");
         return -1;
     }
 
-    // printf("[DEBUG] mm_init() 완료\n");
+    // printf("[DEBUG] heap_init() 완료\n");
     return 0;
 }
 
-void *mm_malloc(size_t size) {
+static void *heap_malloc(size_t size) {
     size_t asize;
-    size_t extendsize;
     char *bp;
 
     if (size == 0)
         return NULL;
+    if (MMAP_THRESHOLD > 0 && size >= MMAP_THRESHOLD)
+        return map_alloc(DSIZE, size);
+    mallocs_since_grow++;
 
-    if (size <= DSIZE)
-        asize = 2 * DSIZE;
-    else
-        asize = DSIZE * ((size + (DSIZE) + (DSIZE - 1)) / DSIZE);
+#if SMALL_RUNS
+    if (use_run(size, 1))
+        return run_alloc(size);
+    if (size <= RUN_MAX_SIZE)
+        small_live++;
+#endif
 
-    if ((bp = find_fit(asize)) != NULL) {
-        place(bp, asize);
+    asize = adjust_size(size);
+
+#if QUICK_LISTS
+    // 같은 크기가 최근에 해제됐으면 분할/병합 없이 바로 재사용
+    if (asize <= QUICK_MAX_SIZE && (bp = quick_lists[asize / DSIZE]) != NULL) {
+        quick_lists[asize / DSIZE] = QUICK_NEXT(bp);
+        quick_bytes -= asize;
+        COUNTER_ADD(coalesce_avoided, 1);
         return bp;
     }
+#endif
+
+    if ((bp = find_fit(asize)) != NULL) {
+        return place(bp, asize);
+    }
+
+    // 맞는 블록이 없으면 미뤄둔 병합과 realloc 예약분을 거둬들이고 다시 찾는다
+    if (relieve_pressure() && (bp = find_fit(asize)) != NULL) {
+        return place(bp, asize);
+    }
 
-    extendsize = (asize > CHUNKSIZE) ? asize : CHUNKSIZE;
-    if ((bp = extend_heap(extendsize / WSIZE)) == NULL) {
-        // printf("extend_heap failed inside mm_malloc\n");
+    if ((bp = grow_heap(asize)) == NULL) {
+        // printf("extend_heap failed inside heap_malloc\n");
         return NULL;
     }
-    place(bp, asize);
-    return bp;
+    return place(bp, asize);
 }
 
-void mm_free(void *ptr) {
+#if QUICK_LISTS
+// 퀵 리스트 바이트가 런 밖의 나머지 할당 바이트보다 많음. 해제가 몰리는 끝 무렵이라 미뤄둔 블록이
+// 힙 끝을 할당 상태로 막아 trim_heap이 못 도는 중이므로 병합해서 (free_block이) 줄이게 한다
+static int quick_pins_heap(void) {
+    size_t live = HEAP_SIZE() - free_bytes - quick_bytes;
+
+#if SMALL_RUNS
+    live -= run_bytes;
+#endif
+    return quick_bytes > live;
+}
+#endif
+
+static void heap_free(void *ptr) {
+    if (IS_MAPPED(ptr)) {
+        map_free(ptr);
+        return;
+    }
+#if SMALL_RUNS
+    if (IS_RUN_SLOT(ptr)) {
+        run_free(ptr);
+        return;
+    }
+    if (small_live > 0 && GET_SIZE(HDRP(ptr)) <= RUN_MAX_SIZE + DSIZE)
+        small_live--;
+#endif
+#if REALLOC_RESERVE
+    if (GET(HDRP(ptr)) & RESERVED)
+        unreserve(ptr);
+#endif
+#if QUICK_LISTS
     size_t size = GET_SIZE(HDRP(ptr));
+    char *next = NEXT_BLKP(ptr);
 
-    PUT(HDRP(ptr), PACK(size, 0));
-    PUT(FTRP(ptr), PACK(size, 0));
-    coalesce(ptr);
+    // 뒤가 프리 블록이나 힙 끝이면 바로 병합해 wilderness를 키운다 (퀵 리스트에 두면 힙 끝을 막는다)
+    if (size <= QUICK_MAX_SIZE && GET_SIZE(HDRP(next)) != 0 && GET_ALLOC(HDRP(next))) {
+        // 헤더는 할당 상태 그대로 두어 이웃이 병합해 가지 않게 한다
+        PUT(HDRP(ptr), GET(HDRP(ptr)) & ~GROWN);   // 재사용될 때 새 블록처럼 보이도록
+        SET_QUICK_NEXT(ptr, quick_lists[size / DSIZE]);
+        quick_lists[size / DSIZE] = ptr;
+        quick_bytes += size;
+        if (quick_bytes > HEAP_SIZE() / QUICK_FRAG_DIV || quick_pins_heap())
+            consolidate();
+        return;
+    }
+#endif
+    free_block(ptr);
+#if QUICK_LISTS
+    if (quick_pins_heap())
+        consolidate();
+#endif
 }
 
-void *mm_realloc(void *ptr, size_t size) {
+static void *heap_realloc(void *ptr, size_t size) {
     size_t oldsize;
     void *newptr;
     size_t asize;
+    size_t copysize;
+    size_t headroom = 0;
+#if REALLOC_RESERVE
+    int reserved = 0;
+#endif
 
     if (ptr == NULL)
-        return mm_malloc(size);
+        return heap_malloc(size);
 
     if (size == 0) {
-        mm_free(ptr);
+        heap_free(ptr);
         return NULL;
     }
+    if (IS_MAPPED(ptr))
+        return map_realloc(ptr, size);
+
+#if SMALL_RUNS
+    if (IS_RUN_SLOT(ptr)) {
+        // 슬롯 안에 들어가면 그대로, 아니면 새로 받아서 슬롯 크기만큼 복사
+        oldsize = RUN_OF(ptr)->slot_size;
+        if (size <= oldsize)
+            return ptr;
+        if ((newptr = heap_malloc(size)) == NULL)
+            return NULL;
+        memcpy(newptr, ptr, oldsize);
+        COUNTER_ADD(realloc_moves, 1);
+        COUNTER_ADD(realloc_copy_bytes, oldsize);
+        run_free(ptr);
+        return newptr;
+    }
+#endif
 
     oldsize = GET_SIZE(HDRP(ptr));
+    asize = adjust_size(size);
+    copysize = oldsize - WSIZE;
 
-    if (size <= DSIZE)
-        asize = 2 * DSIZE;
-    else
-        asize = DSIZE * ((size + (DSIZE) + (DSIZE - 1)) / DSIZE);
+#if REALLOC_RESERVE
+    // 예약 기록은 블록 끝에 있으므로 크기를 건드리기 전에 뺀다. 복사는 예약분을 뺀 실제 페이로드만
+    if (GET(HDRP(ptr)) & RESERVED) {
+        reserved = 1;
+        copysize = GET(RSV_REC(ptr) + 2 * 4) - WSIZE;
+        unreserve(ptr);
+    }
+    // 위로 realloc 된 적이 있는 블록은 계속 자란다고 보고 asize의 절반을 여유로 예약한다
+    if (asize > oldsize && (GET(HDRP(ptr)) & GROWN))
+        headroom = RESERVE_SIZE(asize);
+#endif
 
     if (asize <= oldsize) {
+#if REALLOC_RESERVE
+        // 예약분 안에서 자랐거나 줄었으면 남은 꼬리를 다시 예약
+        if (reserved) {
+            reserve(ptr, asize);
+            return ptr;
+        }
+#endif
+        // 제자리 축소: 꼬리가 분할 기준 이상이면 떼어 뒤 프리 블록과 병합한다
+        split_tail(ptr, asize);
         return ptr;
     } else {
-        void *next_bp = NEXT_BLKP(ptr);
-        size_t next_alloc = GET_ALLOC(HDRP(next_bp));
-        size_t next_size = GET_SIZE(HDRP(next_bp));
+        char *next_bp = NEXT_BLKP(ptr);
+        size_t next_size = GET_ALLOC(HDRP(next_bp)) ? 0 : GET_SIZE(HDRP(next_bp));
+        // 앞 블록이 프리면 그 푸터(내 헤더 바로 앞 워드)에서 크기를 읽는다
+        size_t prev_size = GET_PREV_ALLOC(HDRP(ptr)) ? 0 : GET_SIZE(HDRP(ptr) - WSIZE);
+        int at_top = GET_SIZE(HDRP(next_size ? NEXT_BLKP(next_bp) : next_bp)) == 0;
+        char *bp = ptr;
+        size_t total;
+        // 매핑 크기로 자라는 블록은 sbrk 힙을 늘리지 않고 매핑으로 옮긴다 (heap_malloc과 같은 기준)
+        int to_map = MMAP_THRESHOLD > 0 && size >= MMAP_THRESHOLD;
 
-        if (!next_alloc && (oldsize + next_size) >= asize) {
-            PUT(HDRP(ptr), PACK(oldsize + next_size, 1));
-            PUT(FTRP(ptr), PACK(oldsize + next_size, 1));
-            return ptr;
+        // 힙 끝 블록이고 뒤로 늘려서 모자라면 부족한 만큼만 힙을 늘려 뒤 프리 블록으로 만든다.
+        // 앞 블록 흡수(memmove)보다 싸고, 힙 끝에서는 다음에도 늘리기만 하면 되므로 여유분은 잡지 않는다
+        if (at_top && !to_map && oldsize + next_size < asize) {
+            // 뒤 프리 블록이 없으면 새 조각이 혼자 프리 블록이 되므로 MIN_BLOCK보다 작게 늘리지 않는다
+            total = asize - oldsize - next_size;
+            if (next_size == 0 && total < MIN_BLOCK)
+                total = MIN_BLOCK;
+            if (extend_heap(total / WSIZE) == NULL)
+                return NULL;
+            next_size = GET_SIZE(HDRP(next_bp));
         }
 
-        newptr = mm_malloc(size);
-        if (newptr == NULL)
-            return NULL;
+        if (oldsize + next_size >= asize) {
+            prev_size = 0;      // 뒤로만 늘려도 충분하면 복사 없이 제자리 확장
+        } else if (to_map || prev_size + oldsize + next_size < asize) {
+            newptr = NULL;
+            if (to_map) {
+                newptr = map_alloc(DSIZE, size);
+            } else if (GET(HDRP(ptr)) & GROWN) {
+                // 계속 자라는 블록은 맞는 프리 블록(없으면 퀵 리스트 병합 후 다시)의 앞쪽으로 옮겨 뒤에 자랄 자리를 남기고,
+                // 그래도 없을 때만 wilderness로 옮겨 힙을 늘린다. 예약분은 두지 않는다
+                if ((newptr = find_fit(asize)) != NULL || (relieve_pressure() && (newptr = find_fit(asize)) != NULL))
+                    place_low(newptr, asize);
+                else
+                    newptr = wild_alloc(asize);
+            }
+            if (newptr == NULL && (newptr = heap_malloc(size)) == NULL)
+                return NULL;
 
-        memcpy(newptr, ptr, oldsize - DSIZE);
-        mm_free(ptr);
-        return newptr;
+            memcpy(newptr, ptr, copysize);
+            COUNTER_ADD(realloc_moves, 1);
+            COUNTER_ADD(realloc_copy_bytes, copysize);
+            heap_free(ptr);
+            if (IS_MAPPED(newptr))
+                return newptr;
+#if SMALL_RUNS
+            if (IS_RUN_SLOT(newptr))
+                return newptr;
+#endif
+            PUT(HDRP(newptr), GET(HDRP(newptr)) | GROWN);
+            return newptr;
+        }
+
+        if (next_size > 0) {
+            remove_free(next_bp);
+#if FIT_POLICY == NEXT_FIT
+            if (last_fitp == next_bp)   // 흡수된 블록을 가리키지 않도록
+                last_fitp = ptr - prev_size;
+#endif
+        }
+        total = prev_size + oldsize + next_size;
+        if (prev_size > 0) {
+            // 앞 프리 블록까지 흡수: 겹치는 영역이므로 memmove로 페이로드를 앞으로 당긴다
+            bp = ptr - prev_size;
+            remove_free(bp);
+            PUT(HDRP(bp), PACK(total, 1 | GET_PREV_ALLOC(HDRP(bp))));
+            memmove(bp, ptr, copysize);
+            COUNTER_ADD(realloc_moves, 1);
+            COUNTER_ADD(realloc_copy_bytes, copysize);
+        } else {
+            PUT(HDRP(bp), PACK(total, 1 | GET_PREV_ALLOC(HDRP(bp))));
+        }
+        split_tail(bp, (total > asize + headroom) ? asize + headroom : total);
+        PUT(HDRP(bp), GET(HDRP(bp)) | GROWN);
+#if REALLOC_RESERVE
+        if (headroom > 0)
+            reserve(bp, asize);
+#endif
+        return bp;
+    }
+}
+
+// 0으로 채운 size 바이트 블록. memlib이 한 번도 내준 적 없는 힙은 0이므로 이번 호출에서 힙을 늘려 받은 블록은
+// 그 경계(힙 끝 이상, 전에 줄였던 힙이면 그보다 위) 아래 부분, 그 위 프리 블록 링크 자리,
+// 통째로 받았을 때 남는 wilderness 푸터만 지운다. trim_heap은 힙을 늘리기 전에만 불리므로 경계 위를 더럽히지 않는다
+static void *heap_calloc(size_t size) {
+    char *bp, *clean;
+
+    if (size == 0)
+        return NULL;
+    if (MMAP_THRESHOLD > 0 && size >= MMAP_THRESHOLD)
+        return map_alloc(DSIZE, size);     // 매핑은 항상 새 페이지
+    clean = (char *)HEAP_CLEAN() + FREE_META_SIZE;
+    if ((bp = heap_malloc(size)) == NULL)
+        return NULL;
+#if SMALL_RUNS
+    if (IS_RUN_SLOT(bp)) {
+        zero_fill(bp, size);
+        return bp;
+    }
+#endif
+    if (bp + size <= clean) {
+        zero_fill(bp, size);
+        return bp;
+    }
+    if (bp < clean)
+        zero_fill(bp, clean - bp);
+    if (FTRP(bp) < bp + size)
+        PUT(FTRP(bp), 0);
+    COUNTER_ADD(calloc_clear_skipped, bp + size - (bp < clean ? clean : bp));
+    return bp;
+}
+
+// 페이로드 bp부터 n 바이트를 지운다. 페이로드는 DSIZE 정렬이라 작은 블록은 정렬된 16B 저장으로,
+// 큰 블록은 더 넓은 벡터를 쓰는 libc memset으로. 블록 끝을 넘지 않게 남는 꼬리는 memset
+static void zero_fill(void *bp, size_t n) {
+#ifdef __SSE2__
+    if (n <= ZERO_FILL_VEC_MAX) {
+        __m128i zero = _mm_setzero_si128();
+        char *p = bp;
+        char *end = p + (n & ~(size_t)(DSIZE - 1));
+
+        for (; p < end; p += DSIZE)
+            _mm_store_si128((__m128i *)p, zero);
+        memset(p, 0, n & (DSIZE - 1));
+        return;
+    }
+#endif
+    memset(bp, 0, n);
+}
+
+// 페이로드가 align(2의 거듭제곱) 배수 주소인 size 바이트 블록. DSIZE 이하 정렬은 그냥 malloc.
+// 런 슬롯은 DSIZE 정렬뿐이라 작은 요청도 일반 블록으로 받고, 큰 요청은 페이지 이하 정렬이면 매핑으로
+static void *heap_memalign(size_t align, size_t size) {
+    if (size == 0)
+        return NULL;
+    if (align <= DSIZE)
+        return heap_malloc(size);
+    if (MMAP_THRESHOLD > 0 && size >= MMAP_THRESHOLD && align <= MEM_MAP_PAGE)
+        return map_alloc(align, size);
+    mallocs_since_grow++;
+    return alloc_aligned(align, adjust_size(size));
+}
+
+// 블록에서 실제로 쓸 수 있는 페이로드 바이트 (요청 크기 이상). 예약 꼬리는 빼고, 매핑은 페이지 끝까지
+static size_t heap_usable_size(void *ptr) {
+    if (IS_MAPPED(ptr))
+        return GET_SIZE(HDRP(ptr)) - ((char *)ptr - MAP_BASE(ptr));
+#if SMALL_RUNS
+    if (IS_RUN_SLOT(ptr))
+        return RUN_OF(ptr)->slot_size;
+#endif
+#if REALLOC_RESERVE
+    if (GET(HDRP(ptr)) & RESERVED)
+        return GET(RSV_REC(ptr) + 2 * 4) - WSIZE;
+#endif
+    return GET_SIZE(HDRP(ptr)) - WSIZE;
+}
+
+// 같은 크기 size 블록 n개를 ptrs에 담고 받은 개수를 돌려준다 (힙이 모자라면 n보다 적다).
+// 런 크기가 아닌 BATCH_MIN개 미만은 heap_malloc을 개수만큼 부른다.
+// 퀵 리스트의 같은 크기 블록부터 꺼내고, 나머지가 통째로 들어가는 프리 블록 하나를 찾아 앞에서부터 잘라 나눈다.
+// 그런 블록이 없으면 하나라도 들어가는 블록마다 들어가는 만큼씩, 그것도 없으면 남은 만큼 힙을 한 번에 늘린다
+static size_t heap_malloc_batch(void **ptrs, size_t n, size_t size) {
+    size_t asize, i = 0;
+    char *bp;
+
+    if (size == 0 || n == 0)
+        return 0;
+    if (MMAP_THRESHOLD > 0 && size >= MMAP_THRESHOLD) {
+        for (; i < n && (ptrs[i] = map_alloc(DSIZE, size)) != NULL; i++)
+            ;
+        return i;
+    }
+
+#if SMALL_RUNS
+    if (use_run(size, n)) {
+        mallocs_since_grow += n;
+        return run_alloc_batch(ptrs, n, size);
+    }
+#endif
+    if (n < BATCH_MIN) {
+        for (; i < n && (ptrs[i] = heap_malloc(size)) != NULL; i++)
+            ;
+        return i;
+    }
+    mallocs_since_grow += n;
+#if SMALL_RUNS
+    if (size <= RUN_MAX_SIZE)
+        small_live += n;
+#endif
+
+    asize = adjust_size(size);
+
+#if QUICK_LISTS
+    if (asize <= QUICK_MAX_SIZE) {
+        while (i < n && (bp = quick_lists[asize / DSIZE]) != NULL) {
+            quick_lists[asize / DSIZE] = QUICK_NEXT(bp);
+            quick_bytes -= asize;
+            ptrs[i++] = bp;
+        }
+        COUNTER_ADD(coalesce_avoided, i);
+    }
+#endif
+
+    if (i == n)
+        return i;
+    if ((bp = find_fit((n - i) * asize)) == NULL && relieve_pressure())
+        bp = find_fit((n - i) * asize);
+    while (i < n) {
+        if (bp == NULL && (bp = find_fit(asize)) == NULL && (bp = grow_heap((n - i) * asize)) == NULL)
+            break;
+        i += carve_blocks(bp, asize, n - i, ptrs + i);
+        bp = NULL;
+    }
+    return i;
+}
+
+// 프리 블록 bp 앞에서부터 asize 블록을 최대 n개 잘라 ptrs에 담는다. 잘라낸 개수를 돌려준다.
+// place_low로 통째 한 블록을 할당한 뒤 안쪽에 헤더만 써 넣고, 떼지 못한 꼬리는 마지막 블록에 붙는다
+static size_t carve_blocks(char *bp, size_t asize, size_t n, void **ptrs) {
+    size_t m = GET_SIZE(HDRP(bp)) / asize;
+    size_t total, k;
+    char *p = bp;
+
+    if (m > n)
+        m = n;
+    place_low(bp, m * asize);
+    total = GET_SIZE(HDRP(bp));
+    PUT(HDRP(bp), PACK(asize, GET_FLAGS(HDRP(bp))));
+    for (k = 0; k < m; k++, p += asize) {
+        if (k > 0)
+            PUT(HDRP(p), PACK(asize, 1 | PREV_ALLOC));
+        ptrs[k] = p;
+    }
+    p -= asize;
+    PUT(HDRP(p), PACK(total - (m - 1) * asize, GET_FLAGS(HDRP(p))));
+    return m;
+}
+
+// ptrs의 블록을 해제한다 (NULL은 건너뜀, ptrs는 순서가 바뀐다). 런 슬롯과 매핑은 바로 돌려주고
+// 일반 블록만 앞으로 모아 주소순 정렬한 뒤, 바로 이어 붙은 블록들은 첫 헤더 하나로 묶어 free_block으로 한 번에 병합한다.
+// 혼자 떨어진 블록과 예약 꼬리가 있는 블록은 heap_free로 (퀵 리스트도 그대로 탄다).
+// BATCH_MIN개 미만이면 정렬 없이 하나씩 heap_free.
+// 일반 블록 바로 뒤 페이로드는 일반 블록이거나 런 디스크립터라 이웃 쪽은 예약 비트만 보면 된다
+static void heap_free_batch(void **ptrs, size_t n) {
+    size_t i, j, m, total;
+    char *bp;
+
+    if (n < BATCH_MIN) {
+        for (i = 0; i < n; i++) {
+            if (ptrs[i] != NULL)
+                heap_free(ptrs[i]);
+        }
+        return;
+    }
+
+    for (i = m = 0; i < n; i++) {
+        if ((bp = ptrs[i]) == NULL)
+            continue;
+        if (IS_MAPPED(bp))
+            map_free(bp);
+#if SMALL_RUNS
+        else if (IS_RUN_SLOT(bp))
+            run_free(bp);
+#endif
+        else
+            ptrs[m++] = bp;
+    }
+    sort_ptrs(ptrs, m);
+
+    for (i = 0; i < m; i = j) {
+        bp = ptrs[i];
+        j = i + 1;
+        total = GET_SIZE(HDRP(bp));
+        if (!(GET(HDRP(bp)) & RESERVED)) {
+            for (; j < m && (char *)ptrs[j] == bp + total && !(GET(HDRP(ptrs[j])) & RESERVED); j++)
+                total += GET_SIZE(HDRP(ptrs[j]));
+        }
+        if (j == i + 1) {
+            heap_free(bp);
+            continue;
+        }
+        PUT(HDRP(bp), PACK(total, GET_FLAGS(HDRP(bp))));
+        free_block(bp);
+    }
+}
+
+// 할당 블록 bp를 asize로 줄이고, 남는 꼬리가 최소 블록 이상이면 프리 블록으로 떼어 병합한다.
+// 떼지 않으면 다음 블록의 PREV_ALLOC만 맞춘다
+static void split_tail(void *bp, size_t asize) {
+    size_t csize = GET_SIZE(HDRP(bp));
+    char *rest;
+
+    if (csize - asize < SPLIT_THRESHOLD) {
+        SET_PREV_ALLOC(HDRP(NEXT_BLKP(bp)));
+        return;
     }
+    PUT(HDRP(bp), PACK(asize, GET_FLAGS(HDRP(bp))));
+    rest = NEXT_BLKP(bp);
+    PUT(HDRP(rest), PACK(csize - asize, PREV_ALLOC));
+    PUT(FTRP(rest), PACK(csize - asize, 0));
+    CLEAR_PREV_ALLOC(HDRP(NEXT_BLKP(rest)));
+    coalesce(rest);
 }
 
 static void *extend_heap(size_t words) {
     char *bp;
     size_t size;
 
-    size = (words % 2) ? (words + 1) * WSIZE : words * WSIZE;
+    // 블록 크기는 DSIZE 배수여야 정렬이 유지된다
+    size = DSIZE * ((words * WSIZE + (DSIZE - 1)) / DSIZE);
 
-    if ((bp = mem_sbrk(size)) == (void *)-1) {
+    if ((bp = HEAP_SBRK(size)) == (void *)-1) {
         // printf("[DEBUG] mem_sbrk(size=%zu) 실패\n", size);
         return NULL;
     }
 
-    PUT(HDRP(bp), PACK(size, 0));
+    // 옛 에필로그 자리가 새 블록 헤더가 되므로 앞 블록 할당 비트를 물려받는다
+    PUT(HDRP(bp), PACK(size, GET_PREV_ALLOC(HDRP(bp))));
     PUT(FTRP(bp), PACK(size, 0));
 
     // 에필로그 블록 재설정
     PUT(HDRP(NEXT_BLKP(bp)), PACK(0, 1));
 
+#if FIT_POLICY == NEXT_FIT
     last_fitp = bp;
+#endif
 
     return coalesce(bp);
 }
 
-static void *coalesce(void *bp)
-{
-    size_t prev_alloc = 1;
-    if ((char *)bp > heap_listp) {               /* 프로로그 뒤일 때만 */
-        prev_alloc = GET_ALLOC(HDRP(PREV_BLKP(bp)));  // ← 여기 수정
+// 힙 끝의 프리 블록(wilderness). 힙 끝이 할당 블록이면 NULL
+// 에필로그 헤더의 PREV_ALLOC이 꺼져 있으면 바로 앞 워드가 끝 블록의 푸터
+static char *wild_block(void) {
+    char *epi = EPILOGUE_BP();
+
+    if (GET_PREV_ALLOC(HDRP(epi)))
+        return NULL;
+    return epi - GET_SIZE(HDRP(epi) - WSIZE);
+}
+
+// need 바이트 이상인 프리 블록을 힙을 늘려 만든다.
+// 힙 끝이 프리면 모자란 만큼만 늘려 그 블록과 합치고, 할당 블록이면 chunk_size 단위로 늘린다.
+// chunk_size는 확장이 GROW_BURST번 malloc 안에 반복되면 두 배로, 뜸하면 절반으로 조정 (CHUNKSIZE ~ CHUNK_MAX)
+static void *grow_heap(size_t need) {
+    char *wild = wild_block();
+    size_t extendsize;
+
+    if (wild != NULL && GET_SIZE(HDRP(wild)) < need) {
+        extendsize = need - GET_SIZE(HDRP(wild));
+    } else {
+        if (mallocs_since_grow >= GROW_BURST) {
+            grow_streak = 0;
+            if (mallocs_since_grow >= GROW_BURST * 8 && chunk_size > CHUNKSIZE)
+                chunk_size /= 2;
+        } else if (++grow_streak >= GROW_STREAK && chunk_size < CHUNK_MAX) {
+            chunk_size *= 2;
+            grow_streak = 0;
+        }
+        extendsize = (need > chunk_size) ? need : chunk_size;
+    }
+    mallocs_since_grow = 0;
+    return extend_heap(extendsize / WSIZE);
+}
+
+// wilderness 앞쪽에서 asize를 잘라 할당한다. 모자라면 부족분만큼 힙을 늘린다
+static void *wild_alloc(size_t asize) {
+    char *bp = wild_block();
+
+    if (bp == NULL || GET_SIZE(HDRP(bp)) < asize) {
+        if ((bp = grow_heap(asize)) == NULL)
+            return NULL;
+    }
+    place_low(bp, asize);
+    return bp;
+}
+
+// wilderness가 TRIM_THRESHOLD 이상이면 TRIM_KEEP만 남기고 나머지를 mem_sbrk(음수)로 돌려준다
+static void trim_heap(void) {
+    char *wild = wild_block();
+    size_t size, release;
+#if SMALL_RUNS
+    char *top = (wild != NULL) ? wild : EPILOGUE_BP();
+    run_t *run = (run_t *)(top - RUN_SIZE);
+
+    // 힙 끝 바로 아래가 빈 런이고 그걸 돌려주면 줄일 만큼 프리 공간이 모이면 클래스의 마지막 런이라도 돌려준다.
+    // 런 블록은 페이지 정렬된 RUN_SIZE 크기라 top - RUN_SIZE가 런 페이지면 그 런이 top 바로 앞 블록
+    if (TRIM_THRESHOLD != 0 && (char *)run > heap_listp && (char *)run == (char *)RUN_OF(run)
+        && IS_RUN_SLOT(run) && run->nfree == run->nslots && !GET_PREV_ALLOC(HDRP(run))
+        && GET_SIZE(HDRP(run) - WSIZE) + RUN_SIZE + (wild ? GET_SIZE(HDRP(wild)) : 0) >= TRIM_THRESHOLD) {
+        release_run(run);    // free_block이 병합 후 다시 trim_heap을 부른다
+        return;
     }
+#endif
 
+    if (TRIM_THRESHOLD == 0 || wild == NULL || GET_SIZE(HDRP(wild)) < TRIM_THRESHOLD)
+        return;
+    size = GET_SIZE(HDRP(wild));
+    release = size - TRIM_KEEP;
+    remove_free(wild);
+    PUT(HDRP(wild), PACK(TRIM_KEEP, GET_PREV_ALLOC(HDRP(wild))));
+    PUT(FTRP(wild), PACK(TRIM_KEEP, 0));
+    insert_free(wild);
+    HEAP_SBRK(-(int)release);
+    PUT(HDRP(NEXT_BLKP(wild)), PACK(0, 1));   // 새 에필로그, 앞 블록은 프리
+}
+
+// 호출 전에 bp 다음 블록의 PREV_ALLOC 비트는 이미 지워져 있어야 한다
+static void *coalesce(void *bp)
+{
+    // 앞 블록 푸터는 프리일 때만 있으므로 할당 여부는 내 헤더에서 읽는다
+    size_t prev_alloc = GET_PREV_ALLOC(HDRP(bp));
     size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
     size_t size        = GET_SIZE(HDRP(bp));
 
-    /* 이하 나머지 로직은 그대로 */
+    // 이웃 프리 블록은 병합 전에 리스트에서 빼고, 병합 결과만 다시 넣는다.
+    // 병합 결과의 앞 블록은 항상 할당 상태
 
     if (prev_alloc && next_alloc) {
         // case 1: 앞, 뒤 모두 할당
-        // last_fitp는 bp로 유지
-        last_fitp = bp;
-        return bp;
     } else if (prev_alloc && !next_alloc) {
         // case 2: 앞은 할당, 뒤는 free
+        remove_free(NEXT_BLKP(bp));
         size += GET_SIZE(HDRP(NEXT_BLKP(bp)));
-        PUT(HDRP(bp), PACK(size, 0));
+        PUT(HDRP(bp), PACK(size, PREV_ALLOC));
         PUT(FTRP(bp), PACK(size, 0));
-        last_fitp = bp;
     } else if (!prev_alloc && next_alloc) {
         // case 3: 앞은 free, 뒤는 할당
+        remove_free(PREV_BLKP(bp));
         size += GET_SIZE(HDRP(PREV_BLKP(bp)));
         PUT(FTRP(bp), PACK(size, 0));
-        PUT(HDRP(PREV_BLKP(bp)), PACK(size, 0));
+        PUT(HDRP(PREV_BLKP(bp)), PACK(size, PREV_ALLOC));
         bp = PREV_BLKP(bp);
-        last_fitp = bp;
     } else {
         // case 4: 앞, 뒤 모두 free
+        remove_free(PREV_BLKP(bp));
+        remove_free(NEXT_BLKP(bp));
         size += GET_SIZE(HDRP(PREV_BLKP(bp))) + GET_SIZE(HDRP(NEXT_BLKP(bp)));
-        PUT(HDRP(PREV_BLKP(bp)), PACK(size, 0));
+        PUT(HDRP(PREV_BLKP(bp)), PACK(size, PREV_ALLOC));
         PUT(FTRP(NEXT_BLKP(bp)), PACK(size, 0));
         bp = PREV_BLKP(bp);
-        last_fitp = bp;
     }
+
+#if FIT_POLICY == NEXT_FIT
+    // last_fitp를 병합 결과로 갱신
+    last_fitp = bp;
+#endif
+    insert_free(bp);
     return bp;
 }
 
+#if FREE_LIST == IMPLICIT
+
+#if FIT_POLICY == NEXT_FIT
+// 넥스트 핏은 wilderness를 건너뛰면 힙 전체를 매번 훑게 되므로 일반 블록처럼 취급한다
 static void *find_fit(size_t asize) {
     void *bp;
 
@@ -257,19 +1193,1637 @@ static void *find_fit(size_t asize) {
     return NULL;
 }
 
+#else
 
-static void place(void *bp, size_t asize) {
-    size_t csize = GET_SIZE(HDRP(bp));
+// 프롤로그 다음부터 힙 끝까지 헤더로 건너뛰며 찾는다. 베스트 핏은 끝까지 보고 가장 작은 블록
+static void *find_fit(size_t asize) {
+    char *bp;
+    char *best = NULL;
+
+    for (bp = NEXT_BLKP(heap_listp); GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp)) {
+        if (GET_ALLOC(HDRP(bp)) || GET_SIZE(HDRP(bp)) < asize)
+            continue;
+        if (FIT_POLICY == FIRST_FIT || GET_SIZE(HDRP(bp)) == asize)
+            return bp;
+        if (best == NULL || GET_SIZE(HDRP(bp)) < GET_SIZE(HDRP(best)))
+            best = bp;
+    }
+    return best;
+}
 
-    if ((csize - asize) >= (2 * DSIZE)) {
-        PUT(HDRP(bp), PACK(asize, 1));
-        PUT(FTRP(bp), PACK(asize, 1));
+#endif /* FIT_POLICY */
 
-        void *next_bp = NEXT_BLKP(bp);
-        PUT(HDRP(next_bp), PACK(csize - asize, 0));
-        PUT(FTRP(next_bp), PACK(csize - asize, 0));
+// 묵시적 리스트는 헤더만으로 프리 블록을 찾으므로 바이트 합만 센다
+static void insert_free(void *bp) {
+    free_bytes += GET_SIZE(HDRP(bp));
+}
+
+static void remove_free(void *bp) {
+    free_bytes -= GET_SIZE(HDRP(bp));
+}
+
+#elif FREE_LIST == TLSF
+
+// 블록 크기가 속한 (fl, sl) 리스트
+static inline void tlsf_mapping(size_t size, int *fl, int *sl) {
+    int k;
+
+    if (size < (1UL << TLSF_LINEAR_SHIFT)) {
+        *fl = 0;
+        *sl = size / DSIZE;
+        return;
+    }
+    k = LOG2(size);
+    *fl = k - TLSF_LINEAR_SHIFT + 1;
+    *sl = (size >> (k - TLSF_SL_LOG2)) - TLSF_SL_COUNT;
+}
+
+// 요청을 다음 sl 구간 경계로 올려서 찾으면 그 리스트의 어느 블록이든 맞으므로 리스트를 순회하지 않는다.
+// 비트맵 두 번(같은 fl의 위쪽 sl, 없으면 위쪽 fl)으로 끝나고, 실패하면 asize 자기 구간 머리 하나만 더 본다
+static void *find_fit(size_t asize) {
+    size_t search = asize;
+    unsigned int sl_map;
+    unsigned long fl_map;
+    char *bp;
+    int fl, sl;
+
+    if (asize >= (1UL << TLSF_LINEAR_SHIFT))
+        search += (1UL << (LOG2(asize) - TLSF_SL_LOG2)) - 1;
+    tlsf_mapping(search, &fl, &sl);
+    if (fl < TLSF_FL_COUNT) {
+        sl_map = sl_bitmap[fl] & (~0U << sl);
+        if (sl_map == 0) {
+            fl_map = class_bitmap & (~0UL << (fl + 1));
+            if (fl_map != 0) {
+                fl = __builtin_ctzl(fl_map);
+                sl_map = sl_bitmap[fl];
+            }
+        }
+        if (sl_map != 0)
+            return free_lists[fl][__builtin_ctz(sl_map)];
+    }
+    tlsf_mapping(asize, &fl, &sl);
+    bp = free_lists[fl][sl];
+    if (bp != NULL && GET_SIZE(HDRP(bp)) >= asize)
+        return bp;
+    return NULL;
+}
+
+static void insert_free(void *bp) {
+    char *next;
+    int fl, sl;
+
+    free_bytes += GET_SIZE(HDRP(bp));
+    tlsf_mapping(GET_SIZE(HDRP(bp)), &fl, &sl);
+    next = free_lists[fl][sl];
+    SET_PRED(bp, NULL);
+    SET_SUCC(bp, next);
+    if (next != NULL)
+        SET_PRED(next, bp);
+    free_lists[fl][sl] = bp;
+    sl_bitmap[fl] |= 1U << sl;
+    class_bitmap |= 1UL << fl;
+}
+
+static void remove_free(void *bp) {
+    char *prev = GET_PRED(bp);
+    char *next = GET_SUCC(bp);
+    int fl, sl;
+
+    free_bytes -= GET_SIZE(HDRP(bp));
+    if (prev != NULL) {
+        SET_SUCC(prev, next);
+    } else {
+        tlsf_mapping(GET_SIZE(HDRP(bp)), &fl, &sl);
+        free_lists[fl][sl] = next;
+        if (next == NULL) {
+            sl_bitmap[fl] &= ~(1U << sl);
+            if (sl_bitmap[fl] == 0)
+                class_bitmap &= ~(1UL << fl);
+        }
+    }
+    if (next != NULL)
+        SET_PRED(next, prev);
+}
+
+#else /* FREE_LIST == EXPLICIT || FREE_LIST == SEGREGATED */
+
+#if BEST_FIT_TREE
+
+static char *rotate_right(char *n) {
+    char *l = T_LEFT(n);
+
+    SET_T_LEFT(n, T_RIGHT(l));
+    SET_T_RIGHT(l, n);
+    return l;
+}
+
+static char *rotate_left(char *n) {
+    char *r = T_RIGHT(n);
+
+    SET_T_RIGHT(n, T_LEFT(r));
+    SET_T_LEFT(r, n);
+    return r;
+}
+
+// root 서브트리에 bp를 넣고 새 서브트리 루트를 돌려준다. 같은 크기 노드가 있으면 그 체인에 붙인다
+static char *tree_insert(char *root, char *bp) {
+    size_t size = GET_SIZE(HDRP(bp));
+    size_t rsize;
+    char *child;
+
+    if (root == NULL) {
+        SET_T_LEFT(bp, NULL);
+        SET_T_RIGHT(bp, NULL);
+        SET_T_NEXT(bp, NULL);
+        SET_T_PREV(bp, NULL);
+        SET_T_PRIO(bp, LINK_OFF(bp) * 2654435761u);   // 주소 해시를 우선순위로
+        return bp;
+    }
+    rsize = GET_SIZE(HDRP(root));
+    if (size == rsize) {
+        SET_T_NEXT(bp, T_NEXT(root));
+        SET_T_PREV(bp, root);
+        if (T_NEXT(root) != NULL)
+            SET_T_PREV(T_NEXT(root), bp);
+        SET_T_NEXT(root, bp);
+    } else if (size < rsize) {
+        child = tree_insert(T_LEFT(root), bp);
+        SET_T_LEFT(root, child);
+        if (T_PRIO(child) > T_PRIO(root))
+            root = rotate_right(root);
+    } else {
+        child = tree_insert(T_RIGHT(root), bp);
+        SET_T_RIGHT(root, child);
+        if (T_PRIO(child) > T_PRIO(root))
+            root = rotate_left(root);
+    }
+    return root;
+}
+
+// 체인이 없는 size 노드를 우선순위가 큰 자식 쪽으로 회전시켜 내려 잎에서 뗀다
+// SET_T_* 매크로는 인자를 두 번 평가하므로 재귀 결과는 변수에 받아서 넘긴다
+static char *tree_delete(char *root, size_t size) {
+    size_t rsize = GET_SIZE(HDRP(root));
+    char *l = T_LEFT(root);
+    char *r = T_RIGHT(root);
+    char *child;
+
+    if (size < rsize) {
+        child = tree_delete(l, size);
+        SET_T_LEFT(root, child);
+    } else if (size > rsize) {
+        child = tree_delete(r, size);
+        SET_T_RIGHT(root, child);
+    } else if (l == NULL) {
+        return r;
+    } else if (r == NULL) {
+        return l;
+    } else if (T_PRIO(l) > T_PRIO(r)) {
+        root = rotate_right(root);
+        child = tree_delete(T_RIGHT(root), size);
+        SET_T_RIGHT(root, child);
+    } else {
+        root = rotate_left(root);
+        child = tree_delete(T_LEFT(root), size);
+        SET_T_LEFT(root, child);
+    }
+    return root;
+}
+
+static void tree_remove(char *bp) {
+    char *prev = T_PREV(bp);
+    char *next = T_NEXT(bp);
+    char *n, *parent;
+    size_t size;
+
+    if (prev != NULL) {
+        // 체인 원소: 이중 연결 리스트에서만 뺀다
+        SET_T_NEXT(prev, next);
+        if (next != NULL)
+            SET_T_PREV(next, prev);
+        return;
+    }
+    if (next == NULL) {
+        tree_root = tree_delete(tree_root, GET_SIZE(HDRP(bp)));
+        return;
+    }
+
+    // 체인이 있는 노드: 첫 체인 원소가 노드 자리를 물려받는다
+    SET_T_LEFT(next, T_LEFT(bp));
+    SET_T_RIGHT(next, T_RIGHT(bp));
+    SET_T_PREV(next, NULL);
+    SET_T_PRIO(next, T_PRIO(bp));
+    size = GET_SIZE(HDRP(bp));
+    parent = NULL;
+    for (n = tree_root; n != bp; n = (size < GET_SIZE(HDRP(n))) ? T_LEFT(n) : T_RIGHT(n))
+        parent = n;
+    if (parent == NULL)
+        tree_root = next;
+    else if (T_LEFT(parent) == bp)
+        SET_T_LEFT(parent, next);
+    else
+        SET_T_RIGHT(parent, next);
+}
+
+// asize 이상인 가장 작은 크기의 블록. 체인 원소가 있으면 빼기 싼 체인 원소를 돌려준다
+static char *tree_best(size_t asize) {
+    char *n = tree_root;
+    char *best = NULL;
+    size_t size;
+
+    while (n != NULL) {
+        size = GET_SIZE(HDRP(n));
+        if (size == asize) {
+            best = n;
+            break;
+        }
+        if (size > asize) {
+            best = n;
+            n = T_LEFT(n);
+        } else {
+            n = T_RIGHT(n);
+        }
+    }
+    if (best != NULL && T_NEXT(best) != NULL)
+        return T_NEXT(best);
+    return best;
+}
+
+#endif /* BEST_FIT_TREE */
+
+// 블록 크기가 속한 리스트 번호. 명시적 리스트는 항상 0
+static inline int size_class(size_t size) {
+#if FREE_LIST == SEGREGATED
+    if (size < SMALL_CLASS_LIMIT)
+        return (size - MIN_BLOCK) / DSIZE;
+    return SMALL_CLASSES + LOG2(size) - SMALL_CLASS_SHIFT;
+#else
+    return 0;
+#endif
+}
+
+static void *find_fit(size_t asize) {
+    char *bp;
+    char *wild = wild_block();
+#if FIT_POLICY == BEST_FIT
+    char *best;
+#endif
+    int cls;
+    // 요청 클래스 이상이면서 비어 있지 않은 클래스들
+    unsigned long candidates = class_bitmap & (~0UL << size_class(asize));
+
+    // 할당 블록은 건너뛰고 프리 블록만 순회.
+    // 요청 클래스에 맞는 블록이 없으면 다음으로 비어 있지 않은 클래스로 점프한다 (그 위 클래스는 어느 블록이든 들어맞음)
+    // 클래스끼리는 크기 구간이 겹치지 않으므로 베스트 핏도 맞는 블록이 있는 첫 클래스 안에서만 고르면 된다
+    while (candidates != 0) {
+        cls = __builtin_ctzl(candidates);
+#if FIT_POLICY == BEST_FIT
+        best = NULL;
+        for (bp = free_lists[cls]; bp != NULL; bp = GET_SUCC(bp)) {
+            if (GET_SIZE(HDRP(bp)) < asize || bp == wild)
+                continue;
+            if (GET_SIZE(HDRP(bp)) == asize)
+                return bp;
+            if (best == NULL || GET_SIZE(HDRP(bp)) < GET_SIZE(HDRP(best)))
+                best = bp;
+        }
+        if (best != NULL)
+            return best;
+#else
+        for (bp = free_lists[cls]; bp != NULL; bp = GET_SUCC(bp)) {
+            if (GET_SIZE(HDRP(bp)) >= asize && bp != wild)
+                return bp;
+        }
+#endif
+        candidates &= candidates - 1;
+    }
+#if BEST_FIT_TREE
+    // 리스트에 없으면 큰 블록 트리에서 베스트 핏. wilderness가 뽑히면 그보다 큰 블록이 있는지 한 번 더 본다
+    if ((bp = tree_best(asize)) != NULL) {
+        if (bp != wild)
+            return bp;
+        if ((bp = tree_best(GET_SIZE(HDRP(wild)) + DSIZE)) != NULL)
+            return bp;
+    }
+#endif
+    // wilderness는 다른 블록이 없을 때만 잘라 써서 크고 연속된 채로 남긴다
+    if (wild != NULL && GET_SIZE(HDRP(wild)) >= asize)
+        return wild;
+    return NULL;
+}
+
+static void insert_free(void *bp) {
+    int cls;
+    char **head;
+    char *prev = NULL;
+    char *next;
+
+    free_bytes += GET_SIZE(HDRP(bp));
+#if BEST_FIT_TREE
+    if (IN_TREE(GET_SIZE(HDRP(bp)))) {
+        tree_root = tree_insert(tree_root, bp);
+        return;
+    }
+#endif
+    cls = size_class(GET_SIZE(HDRP(bp)));
+    head = &free_lists[cls];
+    next = *head;
+
+#if INSERT_POLICY == ADDR_ORDER
+    // 주소가 bp보다 큰 첫 블록 앞에 끼워 넣는다
+    while (next != NULL && next < (char *)bp) {
+        prev = next;
+        next = GET_SUCC(next);
+    }
+#endif
+
+    SET_PRED(bp, prev);
+    SET_SUCC(bp, next);
+    if (next != NULL)
+        SET_PRED(next, bp);
+    if (prev != NULL)
+        SET_SUCC(prev, bp);
+    else
+        *head = bp;
+    class_bitmap |= 1UL << cls;
+}
+
+static void remove_free(void *bp) {
+    char *prev, *next;
+    int cls;
+
+    free_bytes -= GET_SIZE(HDRP(bp));
+#if BEST_FIT_TREE
+    if (IN_TREE(GET_SIZE(HDRP(bp)))) {
+        tree_remove(bp);
+        return;
+    }
+#endif
+    prev = GET_PRED(bp);
+    next = GET_SUCC(bp);
+
+    if (prev != NULL) {
+        SET_SUCC(prev, next);
     } else {
-        PUT(HDRP(bp), PACK(csize, 1));
-        PUT(FTRP(bp), PACK(csize, 1));
+        cls = size_class(GET_SIZE(HDRP(bp)));
+        free_lists[cls] = next;
+        if (next == NULL)    // 클래스의 마지막 블록이 빠짐
+            class_bitmap &= ~(1UL << cls);
     }
-}
\ No newline at end of file
+    if (next != NULL)
+        SET_PRED(next, prev);
+}
+
+#endif /* FREE_LIST */
+
+// 배치 방향 정책: PLACE_SPLIT_SIZE 이상 요청은 프리 블록의 뒤쪽 끝에서, 그 미만은 앞쪽 끝에서 잘라
+// 오래 사는 작은 블록과 금방 풀리는 큰 블록이 번갈아 놓이지 않게 한다. 0이면 항상 앞쪽
+static void *place(void *bp, size_t asize) {
+    size_t csize = GET_SIZE(HDRP(bp));
+    char *hi;
+
+    // 남는 조각이 분할 기준보다 작으면 통째로 준다
+    if (csize - asize < SPLIT_THRESHOLD)
+        asize = csize;
+
+    // wilderness는 남은 조각이 힙 끝에 남도록 항상 앞쪽에서 자른다
+    if (PLACE_SPLIT_SIZE == 0 || asize < PLACE_SPLIT_SIZE || csize - asize < MIN_BLOCK
+        || GET_SIZE(HDRP(NEXT_BLKP(bp))) == 0) {
+        place_low(bp, asize);
+        return bp;
+    }
+
+    // 앞쪽 나머지는 프리로 남기고 뒤쪽 asize를 할당. 할당 블록의 앞은 프리이므로 PREV_ALLOC = 0
+    remove_free(bp);
+    PUT(HDRP(bp), PACK(csize - asize, GET_PREV_ALLOC(HDRP(bp))));
+    PUT(FTRP(bp), PACK(csize - asize, 0));
+    insert_free(bp);
+    hi = NEXT_BLKP(bp);
+    PUT(HDRP(hi), PACK(asize, 1));
+    SET_PREV_ALLOC(HDRP(NEXT_BLKP(hi)));
+    return hi;
+}
+
+static void place_low(void *bp, size_t asize) {
+    size_t csize = GET_SIZE(HDRP(bp));
+
+    remove_free(bp);
+
+    if ((csize - asize) >= MIN_BLOCK) {
+        PUT(HDRP(bp), PACK(asize, 1 | GET_PREV_ALLOC(HDRP(bp))));
+
+        // 남은 조각의 다음 블록은 원래부터 PREV_ALLOC = 0
+        void *next_bp = NEXT_BLKP(bp);
+        PUT(HDRP(next_bp), PACK(csize - asize, PREV_ALLOC));
+        PUT(FTRP(next_bp), PACK(csize - asize, 0));
+        insert_free(next_bp);
+    } else {
+        PUT(HDRP(bp), PACK(csize, 1 | GET_PREV_ALLOC(HDRP(bp))));
+        SET_PREV_ALLOC(HDRP(NEXT_BLKP(bp)));
+    }
+}
+
+// 요청 크기를 블록 크기로: 헤더 한 워드를 더하고 DSIZE 배수로 올림 (푸터는 할당 블록에 없음)
+static size_t adjust_size(size_t size) {
+    if (size + WSIZE <= MIN_BLOCK)
+        return MIN_BLOCK;
+    return DSIZE * ((size + WSIZE + (DSIZE - 1)) / DSIZE);
+}
+
+// 경계 태그 블록 해제: 푸터를 쓰고 다음 블록의 PREV_ALLOC을 지운 뒤 병합
+static void free_block(void *bp) {
+    size_t size = GET_SIZE(HDRP(bp));
+
+    PUT(HDRP(bp), PACK(size, GET_PREV_ALLOC(HDRP(bp))));
+    PUT(FTRP(bp), PACK(size, 0));
+    CLEAR_PREV_ALLOC(HDRP(NEXT_BLKP(bp)));
+    coalesce(bp);
+    trim_heap();
+}
+
+#if QUICK_LISTS
+
+// 퀵 리스트에 미뤄둔 블록을 모두 해제/병합한다. 병합한 블록이 있었으면 1
+static int consolidate(void) {
+    char *bp, *next;
+    int i;
+
+    if (quick_bytes == 0)
+        return 0;
+    for (i = 0; i < QUICK_COUNT; i++) {
+        for (bp = quick_lists[i]; bp != NULL; bp = next) {
+            next = QUICK_NEXT(bp);
+            free_block(bp);
+        }
+        quick_lists[i] = NULL;
+    }
+    quick_bytes = 0;
+    COUNTER_ADD(consolidations, 1);
+    return 1;
+}
+
+#endif /* QUICK_LISTS */
+
+#if REALLOC_RESERVE
+
+// 할당 블록 bp 중 asize 뒤의 꼬리를 예약분으로 등록한다. 꼬리가 MIN_BLOCK보다 작으면 예약하지 않음
+static void reserve(void *bp, size_t asize) {
+    char *rec;
+
+    if (GET_SIZE(HDRP(bp)) - asize < MIN_BLOCK)
+        return;
+    PUT(HDRP(bp), GET(HDRP(bp)) | RESERVED);
+    rec = RSV_REC(bp);
+    PUT(rec, 0);
+    PUT(rec + 4, LINK_OFF(reserve_listp));
+    PUT(rec + 2 * 4, asize);
+    if (reserve_listp != NULL)
+        PUT(RSV_REC(reserve_listp), LINK_OFF(bp));
+    reserve_listp = bp;
+}
+
+static void unreserve(void *bp) {
+    char *rec = RSV_REC(bp);
+    char *prev = LINK_PTR(GET(rec));
+    char *next = LINK_PTR(GET(rec + 4));
+
+    if (prev != NULL)
+        PUT(RSV_REC(prev) + 4, LINK_OFF(next));
+    else
+        reserve_listp = next;
+    if (next != NULL)
+        PUT(RSV_REC(next), LINK_OFF(prev));
+    PUT(HDRP(bp), GET(HDRP(bp)) & ~RESERVED);
+}
+
+// 모든 예약분을 떼어 프리 블록으로 돌려준다. 돌려준 게 있으면 1
+static int trim_reserves(void) {
+    char *bp, *next;
+    size_t asize;
+
+    if (reserve_listp == NULL)
+        return 0;
+    for (bp = reserve_listp; bp != NULL; bp = next) {
+        next = LINK_PTR(GET(RSV_REC(bp) + 4));
+        asize = GET(RSV_REC(bp) + 2 * 4);
+        PUT(HDRP(bp), GET(HDRP(bp)) & ~RESERVED);
+        split_tail(bp, asize);
+    }
+    reserve_listp = NULL;
+    return 1;
+}
+
+#endif /* REALLOC_RESERVE */
+
+// 맞는 블록이 없을 때 힙을 늘리기 전에 돌려받을 수 있는 공간을 모은다. 모은 게 있으면 1
+static int relieve_pressure(void) {
+    int freed = 0;
+
+#if QUICK_LISTS
+    freed |= consolidate();
+#endif
+#if REALLOC_RESERVE
+    freed |= trim_reserves();
+#endif
+    return freed;
+}
+
+// 프리 블록이 bp에서 시작할 때 align 경계에 오는 첫 페이로드 자리.
+// 앞에 남는 조각은 0이거나 최소 블록 이상이어야 프리 블록으로 돌려줄 수 있다
+static char *aligned_start(char *bp, size_t align) {
+    char *p = (char *)(((unsigned long)bp + (align - 1)) & ~(unsigned long)(align - 1));
+
+    if (p != bp && (size_t)(p - bp) < MIN_BLOCK)
+        p += align;
+    return p;
+}
+
+// 프리 블록 bp 안에서 align 경계에 페이로드가 오는 asize 블록을 잘라낼 수 있으면 그 페이로드, 아니면 NULL
+static char *aligned_payload_in(char *bp, size_t align, size_t asize) {
+    char *p = aligned_start(bp, align);
+
+    if (p + asize > bp + GET_SIZE(HDRP(bp)))
+        return NULL;
+    return p;
+}
+
+#if FREE_LIST == IMPLICIT
+
+static char *find_aligned_fit(size_t align, size_t asize, char **payload) {
+    char *bp;
+
+    for (bp = NEXT_BLKP(heap_listp); GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp)) {
+        if (!GET_ALLOC(HDRP(bp)) && (*payload = aligned_payload_in(bp, align, asize)) != NULL)
+            return bp;
+    }
+    return NULL;
+}
+
+#elif FREE_LIST == TLSF
+
+// align + MIN_BLOCK만큼 더 큰 블록을 찾으면 어디서 시작하든 정렬 위치가 들어가므로 한 번의 find_fit으로 끝난다
+static char *find_aligned_fit(size_t align, size_t asize, char **payload) {
+    char *bp = find_fit(asize + align + MIN_BLOCK);
+
+    if (bp != NULL)
+        *payload = aligned_payload_in(bp, align, asize);
+    return bp;
+}
+
+#else
+
+#if BEST_FIT_TREE
+// 작은 크기부터 중위 순회하며 정렬 위치가 들어가는 첫 블록을 찾는다. asize 미만 서브트리는 건너뜀
+static char *tree_aligned_fit(char *n, size_t align, size_t asize, char **payload) {
+    char *bp;
+
+    if (n == NULL)
+        return NULL;
+    if (GET_SIZE(HDRP(n)) >= asize) {
+        if ((bp = tree_aligned_fit(T_LEFT(n), align, asize, payload)) != NULL)
+            return bp;
+        for (bp = n; bp != NULL; bp = T_NEXT(bp)) {
+            if ((*payload = aligned_payload_in(bp, align, asize)) != NULL)
+                return bp;
+        }
+    }
+    return tree_aligned_fit(T_RIGHT(n), align, asize, payload);
+}
+
+#endif
+
+static char *find_aligned_fit(size_t align, size_t asize, char **payload) {
+    char *bp;
+    unsigned long candidates = class_bitmap & (~0UL << size_class(asize));
+
+    // 정렬 조건 때문에 요청 클래스 위에서도 안 맞을 수 있으니 블록마다 확인
+    while (candidates != 0) {
+        for (bp = free_lists[__builtin_ctzl(candidates)]; bp != NULL; bp = GET_SUCC(bp)) {
+            if ((*payload = aligned_payload_in(bp, align, asize)) != NULL)
+                return bp;
+        }
+        candidates &= candidates - 1;
+    }
+#if BEST_FIT_TREE
+    return tree_aligned_fit(tree_root, align, asize, payload);
+#else
+    return NULL;
+#endif
+}
+
+#endif /* FREE_LIST */
+
+// 페이로드가 align 경계에 오는 asize 블록을 할당한다. 앞 조각은 프리 블록으로, 뒤 조각은 place가 분할
+static void *alloc_aligned(size_t align, size_t asize) {
+    char *bp, *p, *top;
+    size_t csize, lead;
+
+    bp = find_aligned_fit(align, asize, &p);
+    if (bp == NULL && relieve_pressure())
+        bp = find_aligned_fit(align, asize, &p);
+    if (bp == NULL) {
+        // 늘린 블록은 wilderness(없으면 지금 에필로그 자리)에서 시작하므로 정렬 위치까지만 더 늘린다
+        top = wild_block();
+        if (top == NULL)
+            top = EPILOGUE_BP();
+        if ((bp = grow_heap(aligned_start(top, align) - top + asize)) == NULL)
+            return NULL;
+        p = aligned_payload_in(bp, align, asize);
+    }
+
+    lead = p - bp;
+    if (lead > 0) {
+        csize = GET_SIZE(HDRP(bp));
+        remove_free(bp);
+        PUT(HDRP(bp), PACK(lead, GET_PREV_ALLOC(HDRP(bp))));
+        PUT(FTRP(bp), PACK(lead, 0));
+        insert_free(bp);
+        PUT(HDRP(p), PACK(csize - lead, 0));
+        PUT(FTRP(p), PACK(csize - lead, 0));
+        insert_free(p);
+    }
+    place_low(p, asize);     // 정렬 위치 그대로 써야 하므로 방향 정책 없이 앞에서 자른다
+    return p;
+}
+
+#if SMALL_RUNS
+
+// 빈 슬롯 번호. 256비트 비트맵을 SSE2로 한 번에 훑어 0이 아닌 첫 64비트 워드를 찾는다 (nfree > 0 가정)
+static int first_free_slot(run_t *run) {
+    int w;
+#ifdef __SSE2__
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_loadu_si128((__m128i *)&run->free_bits[0]);
+    __m128i hi = _mm_loadu_si128((__m128i *)&run->free_bits[2]);
+    // 32비트 레인마다 1 = 0인 레인. 64비트 워드는 두 레인이 모두 0일 때만 빈 워드
+    int zero32 = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(lo, zero)))
+               | (_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(hi, zero))) << 4);
+    int nonzero64 = ~(zero32 & (zero32 >> 1)) & 0x55;
+
+    w = __builtin_ctz(nonzero64) / 2;
+#else
+    for (w = 0; run->free_bits[w] == 0; w++)
+        ;
+#endif
+    return w * 64 + __builtin_ctzl(run->free_bits[w]);
+}
+
+// size 요청 n개를 런 슬롯으로 줄지. 그 클래스 런이 없으면 소형 블록이 RUN_MIN_LIVE개 넘게 살아 있을 때만 새 런을 연다:
+// 작은 객체 한두 개에 페이지 정렬 4KiB를 통째로 쓰면 런이 힙 한가운데 박혀 옆 블록이 제자리에서 자라지 못한다
+static int use_run(size_t size, size_t n) {
+    return size <= RUN_MAX_SIZE && (run_lists[(size - 1) / DSIZE] != NULL || small_live + n > RUN_MIN_LIVE);
+}
+
+static run_t *new_run(int cls) {
+    run_t *run;
+    unsigned long page;
+    int i, left;
+
+    if ((run = alloc_aligned(RUN_SIZE, RUN_SIZE)) == NULL)
+        return NULL;
+
+    page = RUN_PAGE(run);
+    STORE_WORD(&run_map[page / 64], run_map[page / 64] | (1UL << (page % 64)));
+    run_bytes += GET_SIZE(HDRP(run));
+
+    // 블록 끝 WSIZE는 다음 블록 헤더 자리라 슬롯으로 쓰지 않는다
+    run->slot_size = (cls + 1) * DSIZE;
+    run->nslots = (RUN_SIZE - WSIZE - RUN_HDR_SIZE) / run->slot_size;
+    run->nfree = run->nslots;
+    run->cls = cls;
+    for (i = 0, left = run->nslots; i < RUN_BITMAP_WORDS; i++, left -= 64) {
+        if (left >= 64)
+            run->free_bits[i] = ~0UL;
+        else if (left > 0)
+            run->free_bits[i] = (1UL << left) - 1;
+        else
+            run->free_bits[i] = 0;
+    }
+
+    run->prev = NULL;
+    run->next = run_lists[cls];
+    if (run->next != NULL)
+        run->next->prev = run;
+    run_lists[cls] = run;
+    return run;
+}
+
+static void *run_alloc(size_t size) {
+    int cls = (size - 1) / DSIZE;
+    run_t *run = run_lists[cls];
+    int slot;
+
+    if (run == NULL && (run = new_run(cls)) == NULL)
+        return NULL;
+
+    slot = first_free_slot(run);
+    run->free_bits[slot / 64] &= ~(1UL << (slot % 64));
+    if (--run->nfree == 0) {
+        // 꽉 찬 런은 리스트에서 뺀다 (머리에서만 꺼내므로 run == run_lists[cls])
+        run_lists[cls] = run->next;
+        if (run->next != NULL)
+            run->next->prev = NULL;
+    }
+    return (char *)run + RUN_HDR_SIZE + slot * run->slot_size;
+}
+
+// 런 슬롯 n개. 머리 런의 빈 슬롯 비트를 워드째 읽어 차례로 꺼내고, 런이 차면 다음 런(없으면 새 런)으로.
+// 새 런에서 꺼낸 슬롯은 주소가 이어진다
+static size_t run_alloc_batch(void **ptrs, size_t n, size_t size) {
+    int cls = (size - 1) / DSIZE;
+    run_t *run;
+    unsigned long bits;
+    char *slots;
+    size_t i = 0;
+    int w;
+
+    while (i < n) {
+        if ((run = run_lists[cls]) == NULL && (run = new_run(cls)) == NULL)
+            break;
+        slots = (char *)run + RUN_HDR_SIZE;
+        for (w = 0; w < RUN_BITMAP_WORDS && i < n; w++) {
+            for (bits = run->free_bits[w]; bits != 0 && i < n; bits &= bits - 1) {
+                ptrs[i++] = slots + (w * 64 + __builtin_ctzl(bits)) * run->slot_size;
+                run->nfree--;
+            }
+            run->free_bits[w] = bits;
+        }
+        if (run->nfree == 0) {
+            run_lists[cls] = run->next;
+            if (run->next != NULL)
+                run->next->prev = NULL;
+        }
+    }
+    return i;
+}
+
+static void run_free(void *ptr) {
+    run_t *run = RUN_OF(ptr);
+    int slot = ((char *)ptr - ((char *)run + RUN_HDR_SIZE)) / run->slot_size;
+
+    run->free_bits[slot / 64] |= 1UL << (slot % 64);
+
+    if (run->nfree++ == 0) {
+        // 꽉 찼던 런이 다시 빈 슬롯을 가짐
+        run->prev = NULL;
+        run->next = run_lists[run->cls];
+        if (run->next != NULL)
+            run->next->prev = run;
+        run_lists[run->cls] = run;
+    } else if (run->nfree == run->nslots) {
+        // 완전히 빈 런은 같은 클래스에 다른 런이 있으면 힙으로 돌려준다.
+        // 마지막 런이면 남겨 두되, 힙 끝을 막고 있으면 trim_heap이 거둬 간다
+        if (run->prev != NULL || run->next != NULL)
+            release_run(run);
+        else
+            trim_heap();
+    }
+}
+
+static void release_run(run_t *run) {
+    unsigned long page;
+
+    if (run->prev != NULL)
+        run->prev->next = run->next;
+    else
+        run_lists[run->cls] = run->next;
+    if (run->next != NULL)
+        run->next->prev = run->prev;
+    page = RUN_PAGE(run);
+    STORE_WORD(&run_map[page / 64], run_map[page / 64] & ~(1UL << (page % 64)));
+    run_bytes -= GET_SIZE(HDRP(run));
+    free_block(run);
+}
+
+#endif /* SMALL_RUNS */
+
+// 매핑 블록. 힙 상태를 건드리지 않으므로 아레나 락 없이 불러도 된다 (memlib이 매핑 공간을 직렬화)
+static void *map_alloc(size_t align, size_t size) {
+    size_t off = (align > DSIZE) ? align : DSIZE;
+    size_t len = MAP_LEN(off, size);
+    char *bp;
+
+    if ((bp = mem_map(len)) == (void *)-1)
+        return NULL;
+    bp += off;
+    PUT(HDRP(bp), PACK(len, 1));
+    return bp;
+}
+
+static void map_free(void *ptr) {
+    mem_unmap(MAP_BASE(ptr), GET_SIZE(HDRP(ptr)));
+}
+
+// 페이지 수가 같으면 그대로, 줄거나 뒤 페이지가 비어 있으면 제자리 (mremap), 아니면 새 매핑으로 복사.
+// 임계값 아래로 줄어도 힙으로 옮기지 않는다
+static void *map_realloc(void *ptr, size_t size) {
+    size_t oldlen = GET_SIZE(HDRP(ptr));
+    size_t off = (char *)ptr - MAP_BASE(ptr);
+    size_t len = MAP_LEN(off, size);
+    char *newptr;
+
+    if (len == oldlen)
+        return ptr;
+    if (mem_remap(MAP_BASE(ptr), oldlen, len) != (void *)-1) {
+        PUT(HDRP(ptr), PACK(len, 1));
+        return ptr;
+    }
+    if ((newptr = map_alloc(DSIZE, size)) == NULL)
+        return NULL;
+    memcpy(newptr, ptr, oldlen - off);
+    COUNTER_ADD(realloc_moves, 1);
+    COUNTER_ADD(realloc_copy_bytes, oldlen - off);
+    map_free(ptr);
+    return newptr;
+}
+
+// 주소순 정렬. 배치로 받은 블록은 대개 이미 주소순이라 확인만 하고 넘어간다
+static int ptr_cmp(const void *a, const void *b) {
+    char *p = *(char * const *)a;
+    char *q = *(char * const *)b;
+
+    return (p > q) - (p < q);
+}
+
+static void sort_ptrs(void **ptrs, size_t n) {
+    size_t i;
+
+    for (i = 1; i < n && (char *)ptrs[i - 1] <= (char *)ptrs[i]; i++)
+        ;
+    if (i < n)
+        qsort(ptrs, n, sizeof(void *), ptr_cmp);
+}
+
+#if !THREAD_SAFE
+
+int mm_init(void) {
+    memset(&mm_counters, 0, sizeof(mm_counters));
+    return heap_init();
+}
+
+void *mm_malloc(size_t size) {
+    return heap_malloc(size);
+}
+
+void mm_free(void *ptr) {
+    heap_free(ptr);
+}
+
+void *mm_realloc(void *ptr, size_t size) {
+    return heap_realloc(ptr, size);
+}
+
+void *mm_calloc(size_t nmemb, size_t size) {
+    if (size != 0 && nmemb > (size_t)-1 / size)
+        return NULL;
+    return heap_calloc(nmemb * size);
+}
+
+void *mm_memalign(size_t alignment, size_t size) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+        return NULL;
+    return heap_memalign(alignment, size);
+}
+
+size_t mm_usable_size(void *ptr) {
+    return ptr == NULL ? 0 : heap_usable_size(ptr);
+}
+
+size_t mm_malloc_batch(void **ptrs, size_t n, size_t size) {
+    return heap_malloc_batch(ptrs, n, size);
+}
+
+// ptrs는 순서가 바뀐다
+void mm_free_batch(void **ptrs, size_t n) {
+    heap_free_batch(ptrs, n);
+}
+
+#else /* THREAD_SAFE */
+
+#if !PERCPU_CACHE
+// 스레드 캐시. 클래스 0 ~ TCACHE_BLOCK_CLASSES-1은 일반 블록(블록 크기 / DSIZE), 그 뒤는 런 슬롯 클래스.
+// 같은 크기라도 일반 블록은 헤더만큼 덜 쓰므로 섞지 않는다.
+// 캐시에 든 블록은 아레나 입장에서는 할당 상태라 어느 스레드가 할당한 블록이든 해제한 스레드의 캐시에 넣으면 된다
+typedef struct {
+    char *head[TCACHE_CLASSES];
+    unsigned int count[TCACHE_CLASSES];
+    unsigned long epoch;        // 채울 때의 heap_epoch. 다르면 mm_init 이전 힙의 블록이라 버린다
+} tcache_t;
+#endif
+
+static unsigned long heap_epoch;        // mm_init마다 증가
+static pthread_once_t locks_once = PTHREAD_ONCE_INIT;
+#if PERCPU_CACHE
+// CPU별 캐시. 리스트 머리는 그 CPU에서 도는 스레드만 rseq 구간 안에서 바꾼다.
+// 구간 도중 선점, CPU 이주, 시그널이 오면 커널이 abort 주소로 돌려보내므로 마지막 커밋 저장까지 다 보이거나 하나도 안 보인다
+typedef struct {
+    char *head[TCACHE_CLASSES];
+} __attribute__((aligned(64))) cpu_cache_t;
+
+static cpu_cache_t cpu_caches[PERCPU_MAX_CPUS];
+#else
+static pthread_key_t tcache_key;        // 스레드 종료 시 캐시를 아레나에 돌려주는 소멸자용
+static pthread_once_t tcache_once = PTHREAD_ONCE_INIT;
+static __thread tcache_t tcache;
+static __thread int tcache_registered;
+#endif
+#if ARENAS
+static pthread_mutex_t arenas_lock = PTHREAD_MUTEX_INITIALIZER;   // 아레나 만들기와 나눠주기
+static int arena_top;                   // arenas[0 .. arena_top-1]이 살아 있는 아레나
+static int arena0_owned;                // arenas[0]을 받은 스레드가 있음
+static unsigned int arena_next_shared;  // 영역이 모자랄 때 돌려 쓸 다음 아레나
+static __thread arena_t *thread_arena_p;
+static __thread unsigned long thread_arena_epoch;
+#endif
+
+static void arenas_init_locks(void) {
+    int i;
+
+    for (i = 0; i < ARENA_COUNT; i++)
+        pthread_mutex_init(&arenas[i].lock, NULL);
+}
+
+// 아레나 락. 잡은 동안 이 스레드의 코어 함수(heap_*)가 a를 다루도록 cur_arena를 바꾼다
+static void arena_lock(arena_t *a) {
+    if (pthread_mutex_trylock(&a->lock) != 0) {
+        COUNTER_ADD(lock_waits, 1);
+        pthread_mutex_lock(&a->lock);
+    }
+#if ARENAS
+    cur_arena = a;
+#endif
+}
+
+static void arena_unlock(arena_t *a) {
+    pthread_mutex_unlock(&a->lock);
+}
+
+// ptr을 할당한 아레나. 아레나 번호는 memlib 영역 번호와 같다
+static arena_t *arena_of(void *ptr) {
+#if ARENAS
+    return &arenas[mem_region_of(ptr)];
+#else
+    return &arenas[0];
+#endif
+}
+
+// 이 스레드가 할당받을 아레나. 처음이거나 mm_init 뒤면 하나 정한다:
+// 첫 스레드는 arenas[0], 그 뒤는 새 memlib 영역으로 아레나를 만들고, 영역이 모자라면 있는 아레나를 돌려 쓴다
+static arena_t *thread_arena(void) {
+#if ARENAS
+    unsigned long epoch = __atomic_load_n(&heap_epoch, __ATOMIC_ACQUIRE);
+    arena_t *a = NULL;
+    int r;
+
+    if (thread_arena_epoch == epoch)
+        return thread_arena_p;
+    pthread_mutex_lock(&arenas_lock);
+    if (!arena0_owned) {
+        a = &arenas[0];
+        arena0_owned = 1;
+    } else if ((r = mem_region_new()) >= 0) {
+        arena_lock(&arenas[r]);
+        arenas[r].region = r;
+        if (heap_init() == 0) {
+            a = &arenas[r];
+            arena_top = r + 1;
+        }
+        arena_unlock(&arenas[r]);
+    }
+    if (a == NULL)
+        a = &arenas[arena_next_shared++ % arena_top];
+    pthread_mutex_unlock(&arenas_lock);
+    thread_arena_p = a;
+    thread_arena_epoch = epoch;
+    return a;
+#else
+    return &arenas[0];
+#endif
+}
+
+#if REMOTE_FREE
+// 이 스레드가 이미 받은 아레나, 아직 malloc을 안 했으면 NULL (free만 하는 스레드에게 아레나를 만들어 주지 않도록)
+static arena_t *thread_arena_peek(void) {
+    return thread_arena_epoch == __atomic_load_n(&heap_epoch, __ATOMIC_ACQUIRE) ? thread_arena_p : NULL;
+}
+
+// 원격 해제 스택을 통째로 떼어 온다 (TC_NEXT로 연결된 채로)
+static char *remote_take(arena_t *a) {
+    char *bp = __atomic_exchange_n(&a->remote_head, NULL, __ATOMIC_ACQUIRE);
+    char *p;
+    unsigned int n = 0;
+
+    for (p = bp; p != NULL; p = TC_NEXT(p))
+        n++;
+    __atomic_fetch_sub(&a->remote_count, n, __ATOMIC_RELAXED);
+    return bp;
+}
+
+// 떼어 온 블록들을 아레나에 해제한다. 아레나 락을 잡은 상태에서 부른다
+static void remote_free_locked(char *bp) {
+    char *next;
+
+    for (; bp != NULL; bp = next) {
+        next = TC_NEXT(bp);
+        heap_free(bp);
+    }
+}
+
+// 주인 아레나의 스택에 얹는다 (여러 생산자, 소비자는 통째로 떼어 가기만 해서 ABA가 없음).
+// 주인이 한동안 malloc을 안 해 REMOTE_DRAIN_LIMIT개가 쌓이면, 락이 비어 있을 때만 대신 해제한다
+static void remote_push(arena_t *a, char *bp) {
+    char *head = __atomic_load_n(&a->remote_head, __ATOMIC_RELAXED);
+
+    do {
+        TC_NEXT(bp) = head;
+    } while (!__atomic_compare_exchange_n(&a->remote_head, &head, bp, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    COUNTER_ADD(remote_frees, 1);
+    if (__atomic_add_fetch(&a->remote_count, 1, __ATOMIC_RELAXED) >= REMOTE_DRAIN_LIMIT &&
+        pthread_mutex_trylock(&a->lock) == 0) {
+        cur_arena = a;
+        remote_free_locked(remote_take(a));
+        arena_unlock(a);
+    }
+}
+#endif
+
+// size 요청을 받을 수 있는 캐시 클래스, 캐시하지 않는 크기면 -1
+static int tc_request_class(size_t size) {
+    size_t asize;
+
+#if SMALL_RUNS
+    if (size <= RUN_MAX_SIZE)
+        return TCACHE_BLOCK_CLASSES + (size - 1) / DSIZE;
+#endif
+    asize = adjust_size(size);
+    return asize <= TCACHE_MAX_SIZE ? (int)(asize / DSIZE) : -1;
+}
+
+// 캐시 클래스 cls를 채울 블록 요청 크기. 런 클래스는 아직 런이 없으면 일반 블록으로 오므로
+// 그 클래스의 어떤 요청도 담게 슬롯 크기로 받는다
+static size_t tc_fill_size(int cls, size_t size) {
+#if SMALL_RUNS
+    if (cls >= TCACHE_BLOCK_CLASSES)
+        return (size_t)(cls - TCACHE_BLOCK_CLASSES + 1) * DSIZE;
+#endif
+    return size;
+}
+
+// 해제되는 블록이 들어갈 캐시 클래스, 아레나로 바로 보내야 하면 -1.
+// 락 없이 읽지만 런 맵 비트와 헤더 크기는 이 블록이 할당돼 있는 동안 바뀌지 않는다 (PREV_ALLOC만 바뀔 수 있음).
+// 예약 꼬리나 GROWN 표시가 있는 블록은 아레나가 정리해야 하므로 캐시하지 않는다
+static int tc_block_class(void *ptr) {
+    unsigned int hdr;
+
+#if ARENAS
+    cur_arena = arena_of(ptr);      // 런 맵과 heap_listp는 블록 주인 아레나 것
+#endif
+#if SMALL_RUNS
+    unsigned long page = RUN_PAGE(ptr);
+
+    if ((LOAD_WORD(&run_map[page / 64]) >> (page % 64)) & 1)
+        return TCACHE_BLOCK_CLASSES + RUN_OF(ptr)->cls;
+#endif
+    hdr = GET(HDRP(ptr));
+    if ((hdr & (RESERVED | GROWN)) || (hdr & ~0xF) > TCACHE_MAX_SIZE)
+        return -1;
+#if SMALL_RUNS
+    // 런을 열기 전에 일반 블록으로 준 소형 블록은 페이로드가 담을 수 있는 가장 큰 런 클래스로 (못 담으면 아레나로)
+    if ((hdr & ~0xF) <= RUN_MAX_SIZE + DSIZE) {
+        int slots = ((hdr & ~0xF) - WSIZE) / DSIZE;     // 페이로드에 들어가는 DSIZE 칸 수
+        return slots > 0 ? TCACHE_BLOCK_CLASSES + slots - 1 : -1;
+    }
+#endif
+    return (hdr & ~0xF) / DSIZE;
+}
+
+#if PERCPU_CACHE
+#if HAVE_RSEQ
+// rseq 구간 머리: 구간 기술자(__rseq_cs 섹션)를 등록하고 지금 CPU가 cpu인지 확인한다.
+// abort 코드는 커널이 확인하는 서명(RSEQ_SIG) 바로 뒤에 둔다
+#define RSEQ_ENTER                                          \
+    ".pushsection __rseq_cs, \"aw\"\n\t"                  \
+    ".balign 32\n\t"                                        \
+    "3:\n\t"                                                \
+    ".long 0x0, 0x0\n\t"                                    \
+    ".quad 1f, (2f - 1f), 4f\n\t"                           \
+    ".popsection\n\t"                                       \
+    "leaq 3b(%%rip), %%rax\n\t"                             \
+    "movq %%rax, %[rseq_cs]\n\t"                            \
+    "1:\n\t"                                                \
+    "cmpl %[cpu], %[cur_cpu]\n\t"                           \
+    "jnz 4f\n\t"
+#define RSEQ_LEAVE                                          \
+    "2:\n\t"                                                \
+    ".pushsection __rseq_failure, \"ax\"\n\t"             \
+    ".byte 0x0f, 0xb9, 0x3d\n\t"                            \
+    ".long 0x53053053\n\t"                                  \
+    "4:\n\t"                                                \
+    "jmp %l[aborted]\n\t"                                   \
+    ".popsection\n\t"
+
+static struct rseq *rseq_area(void) {
+    return (struct rseq *)((char *)__builtin_thread_pointer() + __rseq_offset);
+}
+
+// cpu 캐시 리스트 *headp의 머리를 꺼낸다. 0 = 꺼냄, 1 = 비었음, -1 = 중단됨 (다시 시도)
+static inline int rseq_pop(char **headp, int cpu, char **out) {
+    struct rseq *rs = rseq_area();
+
+    __asm__ goto(RSEQ_ENTER
+                 "movq %[head], %%rbx\n\t"
+                 "testq %%rbx, %%rbx\n\t"
+                 "jz %l[empty]\n\t"
+                 "movq %%rbx, %[out]\n\t"
+                 "movq (%%rbx), %%rbx\n\t"
+                 "movq %%rbx, %[head]\n\t"        // 커밋
+                 RSEQ_LEAVE
+                 :
+                 : [cpu] "r" (cpu), [cur_cpu] "m" (rs->cpu_id), [rseq_cs] "m" (rs->rseq_cs),
+                   [head] "m" (*headp), [out] "m" (*out)
+                 : "memory", "cc", "rax", "rbx"
+                 : empty, aborted);
+    return 0;
+empty:
+    return 1;
+aborted:
+    return -1;
+}
+
+// bp를 cpu 캐시 리스트 *headp 머리에 넣는다. 블록 둘째 워드(오프셋 8)에 자기부터 리스트 끝까지 개수를 두어
+// 머리 블록 것에 하나 더해 적는다 (최소 블록 페이로드 12B에 다음 포인터와 함께 들어감).
+// 0 = 넣음, 1 = TCACHE_LIMIT개라 가득 참, -1 = 중단됨 (다시 시도)
+static inline int rseq_push(char **headp, int cpu, char *bp) {
+    struct rseq *rs = rseq_area();
+
+    __asm__ goto(RSEQ_ENTER
+                 "movq %[head], %%rbx\n\t"
+                 "xorl %%ecx, %%ecx\n\t"
+                 "testq %%rbx, %%rbx\n\t"
+                 "jz 5f\n\t"
+                 "movl 8(%%rbx), %%ecx\n\t"
+                 "cmpl %[limit], %%ecx\n\t"
+                 "jae %l[full]\n\t"
+                 "5:\n\t"
+                 "incl %%ecx\n\t"
+                 "movq %%rbx, (%[bp])\n\t"
+                 "movl %%ecx, 8(%[bp])\n\t"
+                 "movq %[bp], %[head]\n\t"        // 커밋
+                 RSEQ_LEAVE
+                 :
+                 : [cpu] "r" (cpu), [cur_cpu] "m" (rs->cpu_id), [rseq_cs] "m" (rs->rseq_cs),
+                   [head] "m" (*headp), [bp] "r" (bp), [limit] "i" (TCACHE_LIMIT)
+                 : "memory", "cc", "rax", "rbx", "rcx"
+                 : full, aborted);
+    return 0;
+full:
+    return 1;
+aborted:
+    return -1;
+}
+#endif
+
+// 지금 CPU 번호, rseq가 없거나(등록 실패, 다른 아키텍처) 번호가 너무 크면 -1 (락 경로로)
+static int cpu_current(void) {
+#if HAVE_RSEQ
+    int cpu = (int)__atomic_load_n(&rseq_area()->cpu_id, __ATOMIC_RELAXED);
+
+    return cpu < PERCPU_MAX_CPUS ? cpu : -1;
+#else
+    return -1;
+#endif
+}
+
+// 이 CPU 캐시에서 cls 블록 하나, 없으면 NULL
+static char *cpu_cache_pop(int cls) {
+#if HAVE_RSEQ
+    char *bp;
+    int cpu, ret;
+
+    do {
+        if ((cpu = cpu_current()) < 0)
+            return NULL;
+        ret = rseq_pop(&cpu_caches[cpu].head[cls], cpu, &bp);
+    } while (ret < 0);
+    return ret == 0 ? bp : NULL;
+#else
+    return NULL;
+#endif
+}
+
+// 이 CPU 캐시에 넣는다. 0 = 넣음, 1 = 가득 찼거나 rseq가 없어 못 넣음
+static int cpu_cache_push(int cls, char *bp) {
+#if HAVE_RSEQ
+    int cpu, ret;
+
+    do {
+        if ((cpu = cpu_current()) < 0)
+            return 1;
+        ret = rseq_push(&cpu_caches[cpu].head[cls], cpu, bp);
+    } while (ret < 0);
+    return ret;
+#else
+    return 1;
+#endif
+}
+
+// 캐시에 못 넣은 bp와, 가득 찬 경우 이 CPU 캐시의 TCACHE_BATCH개를 주인 아레나에 돌려준다
+static void cpu_cache_flush(int cls, char *bp) {
+    arena_t *held = NULL;
+    arena_t *a;
+    int n = 0;
+
+    do {
+        a = arena_of(bp);
+        if (a != held) {
+            if (held != NULL)
+                arena_unlock(held);
+            arena_lock(a);
+            held = a;
+        }
+        heap_free(bp);
+    } while (n++ < TCACHE_BATCH && (bp = cpu_cache_pop(cls)) != NULL);
+    arena_unlock(held);
+}
+
+#else /* !PERCPU_CACHE */
+
+// 넘침: 캐시 앞쪽 n개를 주인 아레나에 돌려준다. 주인이 같은 블록이 이어지면 락을 한 번만 잡는다
+static void tcache_flush(tcache_t *tc, int cls, int n) {
+    arena_t *held = NULL;
+    arena_t *a;
+    char *bp;
+
+    while (n-- > 0 && (bp = tc->head[cls]) != NULL) {
+        tc->head[cls] = TC_NEXT(bp);
+        tc->count[cls]--;
+        a = arena_of(bp);
+        if (a != held) {
+            if (held != NULL)
+                arena_unlock(held);
+            arena_lock(a);
+            held = a;
+        }
+        heap_free(bp);
+    }
+    if (held != NULL)
+        arena_unlock(held);
+}
+
+#if REMOTE_FREE
+// 주인 스레드가 malloc 때 부른다. 캐시에 자리가 있는 블록은 락 없이 캐시로 옮기고 나머지만 락 한 번에 해제
+static void remote_drain(arena_t *a, tcache_t *tc) {
+    char *bp, *next;
+    char *rest = NULL;
+    int cls;
+
+    for (bp = remote_take(a); bp != NULL; bp = next) {
+        next = TC_NEXT(bp);
+        if ((cls = tc_block_class(bp)) >= 0 && tc->count[cls] < TCACHE_LIMIT) {
+            TC_NEXT(bp) = tc->head[cls];
+            tc->head[cls] = bp;
+            tc->count[cls]++;
+        } else {
+            TC_NEXT(bp) = rest;
+            rest = bp;
+        }
+    }
+    if (rest != NULL) {
+        arena_lock(a);
+        remote_free_locked(rest);
+        arena_unlock(a);
+    }
+}
+#endif
+
+// 스레드 종료 시 남은 캐시를 돌려준다 (원격 해제 모드면 내 아레나 스택도 비운다)
+static void tcache_release(void *arg) {
+    tcache_t *tc = arg;
+    int cls;
+#if REMOTE_FREE
+    arena_t *a;
+#endif
+
+    if (tc->epoch != __atomic_load_n(&heap_epoch, __ATOMIC_ACQUIRE))
+        return;
+    for (cls = 0; cls < TCACHE_CLASSES; cls++)
+        tcache_flush(tc, cls, tc->count[cls]);
+#if REMOTE_FREE
+    if ((a = thread_arena_peek()) != NULL) {   // 주인이 없어지면 다음 drain이 언제일지 모름
+        arena_lock(a);
+        remote_free_locked(remote_take(a));
+        arena_unlock(a);
+    }
+#endif
+}
+
+static void tcache_key_init(void) {
+    pthread_key_create(&tcache_key, tcache_release);
+}
+
+// 이 스레드의 캐시. 처음 쓰거나 mm_init으로 힙이 바뀐 뒤면 비우고 시작한다
+static tcache_t *tcache_get(void) {
+    unsigned long epoch = __atomic_load_n(&heap_epoch, __ATOMIC_ACQUIRE);
+
+    if (tcache.epoch != epoch) {
+        memset(tcache.head, 0, sizeof(tcache.head));
+        memset(tcache.count, 0, sizeof(tcache.count));
+        tcache.epoch = epoch;
+        if (!tcache_registered) {
+            pthread_once(&tcache_once, tcache_key_init);
+            pthread_setspecific(tcache_key, &tcache);
+            tcache_registered = 1;
+        }
+    }
+    return &tcache;
+}
+
+// 미스: 락 한 번에 요청 하나와 같은 크기 TCACHE_BATCH - 1개를 더 받아 캐시에 채운다
+static void *tcache_refill(tcache_t *tc, int cls, size_t size) {
+    arena_t *a = thread_arena();
+    char *bp, *extra;
+    int i;
+
+    arena_lock(a);
+    bp = heap_malloc(size);
+    for (i = 1; bp != NULL && i < TCACHE_BATCH; i++) {
+        if ((extra = heap_malloc(tc_fill_size(cls, size))) == NULL)
+            break;
+        TC_NEXT(extra) = tc->head[cls];
+        tc->head[cls] = extra;
+        tc->count[cls]++;
+    }
+    arena_unlock(a);
+    return bp;
+}
+
+#endif /* PERCPU_CACHE */
+
+// 다른 스레드가 할당기를 쓰지 않을 때만 부른다 (드라이버는 트레이스마다 한 스레드에서 부름).
+// 아레나 모드에서는 mem_reset_brk 뒤에 불러야 이전 아레나들의 영역이 비워진다
+int mm_init(void) {
+    int ret;
+#if REMOTE_FREE
+    int i;
+#endif
+
+    pthread_once(&locks_once, arenas_init_locks);
+#if ARENAS
+    pthread_mutex_lock(&arenas_lock);
+    arena_top = 1;
+    arena0_owned = 0;
+    arena_next_shared = 0;
+#endif
+#if REMOTE_FREE
+    for (i = 0; i < ARENA_COUNT; i++) {
+        arenas[i].remote_head = NULL;
+        arenas[i].remote_count = 0;
+    }
+#endif
+#if PERCPU_CACHE
+    memset(cpu_caches, 0, sizeof(cpu_caches));
+#endif
+    arena_lock(&arenas[0]);
+    memset(&mm_counters, 0, sizeof(mm_counters));
+    ret = heap_init();
+    __atomic_add_fetch(&heap_epoch, 1, __ATOMIC_RELEASE);
+    arena_unlock(&arenas[0]);
+#if ARENAS
+    pthread_mutex_unlock(&arenas_lock);
+#endif
+    return ret;
+}
+
+#if PERCPU_CACHE
+void *mm_malloc(size_t size) {
+    arena_t *a;
+    char *bp, *extra;
+    int cls, i;
+
+    if (size == 0)
+        return NULL;
+    if ((cls = tc_request_class(size)) >= 0 && (bp = cpu_cache_pop(cls)) != NULL)
+        return bp;
+    a = thread_arena();
+    arena_lock(a);
+    bp = heap_malloc(size);
+    // 미스: 같은 크기 TCACHE_BATCH - 1개를 더 받아 이 CPU 캐시를 채운다. 못 넣으면 바로 돌려준다
+    for (i = 1; cls >= 0 && bp != NULL && i < TCACHE_BATCH && cpu_current() >= 0; i++) {
+        if ((extra = heap_malloc(tc_fill_size(cls, size))) == NULL)
+            break;
+        if (cpu_cache_push(cls, extra) != 0) {
+            heap_free(extra);
+            break;
+        }
+    }
+    arena_unlock(a);
+    return bp;
+}
+
+// 어느 아레나 블록이든 지금 CPU 캐시에 넣는다. 가득 찼으면 캐시 일부와 함께 주인 아레나로
+void mm_free(void *ptr) {
+    arena_t *a;
+    int cls;
+
+    if (ptr == NULL)
+        return;
+    if (IS_MAPPED(ptr)) {
+        map_free(ptr);
+        return;
+    }
+    if ((cls = tc_block_class(ptr)) >= 0) {
+        if (cpu_cache_push(cls, ptr) != 0)
+            cpu_cache_flush(cls, ptr);
+        return;
+    }
+    a = arena_of(ptr);
+    arena_lock(a);
+    heap_free(ptr);
+    arena_unlock(a);
+}
+
+#else /* !PERCPU_CACHE */
+
+void *mm_malloc(size_t size) {
+    tcache_t *tc;
+    arena_t *a;
+    char *bp;
+    int cls;
+
+    if (size == 0)
+        return NULL;
+#if REMOTE_FREE
+    a = thread_arena();
+    if (__atomic_load_n(&a->remote_head, __ATOMIC_RELAXED) != NULL)
+        remote_drain(a, tcache_get());
+#endif
+    if ((cls = tc_request_class(size)) < 0) {
+        a = thread_arena();
+        arena_lock(a);
+        bp = heap_malloc(size);
+        arena_unlock(a);
+        return bp;
+    }
+    tc = tcache_get();
+    if ((bp = tc->head[cls]) != NULL) {
+        tc->head[cls] = TC_NEXT(bp);
+        tc->count[cls]--;
+        return bp;
+    }
+    return tcache_refill(tc, cls, size);
+}
+
+// 다른 아레나가 할당한 블록도 여기서 받는다. 캐시에 못 넣으면 주인 아레나의 락을 잡고 돌려준다.
+// 원격 해제 모드에서는 남의 블록은 캐시하지 않고 주인의 원격 해제 스택으로 보낸다
+void mm_free(void *ptr) {
+    tcache_t *tc;
+    arena_t *a;
+    int cls;
+
+    if (ptr == NULL)
+        return;
+    if (IS_MAPPED(ptr)) {
+        map_free(ptr);
+        return;
+    }
+#if REMOTE_FREE
+    if ((a = arena_of(ptr)) != thread_arena_peek()) {
+        remote_push(a, ptr);
+        return;
+    }
+#endif
+    if ((cls = tc_block_class(ptr)) < 0) {
+        a = arena_of(ptr);
+        arena_lock(a);
+        heap_free(ptr);
+        arena_unlock(a);
+        return;
+    }
+    tc = tcache_get();
+    if (tc->count[cls] >= TCACHE_LIMIT)
+        tcache_flush(tc, cls, TCACHE_BATCH);
+    TC_NEXT(ptr) = tc->head[cls];
+    tc->head[cls] = ptr;
+    tc->count[cls]++;
+}
+
+#endif /* PERCPU_CACHE */
+
+// 블록은 주인 아레나 안에서 늘이거나 옮긴다 (매핑 블록은 락 없이)
+void *mm_realloc(void *ptr, size_t size) {
+    arena_t *a;
+    void *newptr;
+
+    if (ptr == NULL)
+        return mm_malloc(size);
+    if (size == 0) {
+        mm_free(ptr);
+        return NULL;
+    }
+    if (IS_MAPPED(ptr))
+        return map_realloc(ptr, size);
+    a = arena_of(ptr);
+    arena_lock(a);
+    newptr = heap_realloc(ptr, size);
+    arena_unlock(a);
+    return newptr;
+}
+
+// 캐시 크기는 캐시에서 나온 재활용 블록일 수 있으니 통째로 지우고, 나머지는 아레나 안에서 새 힙 여부를 본다
+void *mm_calloc(size_t nmemb, size_t size) {
+    arena_t *a;
+    char *bp;
+    size_t bytes;
+
+    if (size != 0 && nmemb > (size_t)-1 / size)
+        return NULL;
+    bytes = nmemb * size;
+    if (bytes == 0)
+        return NULL;
+    if (bytes <= TCACHE_MAX_SIZE && tc_request_class(bytes) >= 0) {
+        if ((bp = mm_malloc(bytes)) != NULL)
+            zero_fill(bp, bytes);
+        return bp;
+    }
+    a = thread_arena();
+    arena_lock(a);
+    bp = heap_calloc(bytes);
+    arena_unlock(a);
+    return bp;
+}
+
+// 정렬 블록은 캐시 클래스와 상관없이 아레나에서 바로 받는다 (해제는 보통 블록과 같음)
+void *mm_memalign(size_t alignment, size_t size) {
+    arena_t *a;
+    char *bp;
+
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+        return NULL;
+    a = thread_arena();
+    arena_lock(a);
+    bp = heap_memalign(alignment, size);
+    arena_unlock(a);
+    return bp;
+}
+
+// 예약 꼬리는 다른 스레드의 trim_reserves가 떼어 갈 수 있으므로 매핑이 아니면 주인 아레나 락을 잡고 읽는다
+size_t mm_usable_size(void *ptr) {
+    arena_t *a;
+    size_t usable;
+
+    if (ptr == NULL)
+        return 0;
+    if (IS_MAPPED(ptr))
+        return heap_usable_size(ptr);
+    a = arena_of(ptr);
+    arena_lock(a);
+    usable = heap_usable_size(ptr);
+    arena_unlock(a);
+    return usable;
+}
+
+// 캐시를 거치지 않고 아레나 락 한 번에 n개를 받는다
+size_t mm_malloc_batch(void **ptrs, size_t n, size_t size) {
+    arena_t *a = thread_arena();
+    size_t got;
+
+    arena_lock(a);
+    got = heap_malloc_batch(ptrs, n, size);
+    arena_unlock(a);
+    return got;
+}
+
+// 캐시와 원격 해제 스택을 거치지 않고 주인 아레나에 바로 돌려준다. 아레나 모드에서는 주소순으로 정렬하면
+// 같은 아레나(memlib 영역) 블록끼리 모이므로 아레나마다 락을 한 번만 잡는다. ptrs는 순서가 바뀐다
+void mm_free_batch(void **ptrs, size_t n) {
+    arena_t *a;
+    size_t i, j;
+
+#if ARENAS
+    sort_ptrs(ptrs, n);
+#endif
+    for (i = 0; i < n; i = j) {
+        j = i + 1;
+        if (ptrs[i] == NULL)
+            continue;
+        if (IS_MAPPED(ptrs[i])) {
+            map_free(ptrs[i]);
+            continue;
+        }
+        a = arena_of(ptrs[i]);
+        while (j < n && (ptrs[j] == NULL || IS_MAPPED(ptrs[j]) || arena_of(ptrs[j]) == a))
+            j++;
+        arena_lock(a);
+        heap_free_batch(ptrs + i, j - i);
+        arena_unlock(a);
+    }
+}
+
+#endif /* THREAD_SAFE */
+
+// C11 aligned_alloc. 크기가 정렬의 배수일 필요는 없다 (C17처럼 받아 준다)
+void *mm_aligned_alloc(size_t alignment, size_t size) {
+    return mm_memalign(alignment, size);
+}
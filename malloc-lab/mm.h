@@ -4,6 +4,35 @@ extern int mm_init (void);
 extern void *mm_malloc (size_t size);
 extern void mm_free (void *ptr);
 extern void *mm_realloc(void *ptr, size_t size);
+extern void *mm_calloc(size_t nmemb, size_t size);
+extern void *mm_memalign(size_t alignment, size_t size);
+extern void *mm_aligned_alloc(size_t alignment, size_t size);
+extern size_t mm_usable_size(void *ptr);
+extern size_t mm_malloc_batch(void **ptrs, size_t n, size_t size);
+extern void mm_free_batch(void **ptrs, size_t n);
+
+/*
+ * Event counters kept by the mm package and reported by the driver
+ * with -v. mm_init resets them.
+ */
+typedef struct {
+    unsigned long coalesce_avoided; /* mallocs served from a quick list without split/coalesce */
+    unsigned long consolidations;   /* batch passes that coalesced the quick lists */
+    unsigned long realloc_moves;    /* reallocs that moved the payload to a new address */
+    unsigned long realloc_copy_bytes; /* payload bytes copied by those moves */
+    unsigned long live_block_bytes; /* bytes in blocks currently handed out (0 = not tracked) */
+    unsigned long lock_waits;       /* lock acquisitions that found the lock held */
+    unsigned long remote_frees;     /* frees handed to another thread's arena without its lock */
+    unsigned long calloc_clear_skipped; /* calloc bytes left as is because memlib never handed them out */
+} mm_counters_t;
+
+extern mm_counters_t mm_counters;
+
+/*
+ * Nonzero if the mm package may be called from several threads at
+ * once. The driver refuses -p when it is zero.
+ */
+extern const int mm_thread_safe;
 
 
 /* 
@@ -0,0 +1,285 @@
+//이진 버디 할당기 = mm.c와 같은 인터페이스(mm_init/mm_malloc/mm_free/mm_realloc/mm_calloc/mm_memalign/mm_usable_size/mm_malloc_batch/mm_free_batch), make mdriver-buddy로 따로 빌드
+//블록 크기는 2^order (order >= MIN_ORDER), 블록 오프셋(힙 시작 기준)은 항상 자기 크기의 배수
+//버디 = 오프셋 ^ 2^order 이므로 병합에 푸터가 필요 없다
+//블록 헤더도 없다. 블록 시작 16B 단위마다 한 바이트짜리 order 맵(힙 밖 정적 배열)에 order와 프리 여부를 기록
+//order별 이중 연결 프리 리스트 + 비어 있지 않은 order 비트맵, 탐색은 ctz 한 번, 큰 블록을 반씩 쪼개 내려옴
+//힙 확장 = 요청 order 경계까지 올린 뒤 그 블록만큼만 mem_sbrk, 경계 맞추느라 생긴 틈은 정렬된 최대 블록들로 프리 리스트에
+//realloc = 줄이면 위쪽 반들을 프리로 돌려주며 제자리에서 order를 내림, 늘리면 자기가 아래쪽 반이고 위쪽 버디들이 프리(또는 힙 끝 너머)면 제자리에서 order를 올림, 아니면 malloc + memcpy + free
+//내부 단편화(2^order로 올린 만큼)는 mm_counters.live_block_bytes로 드라이버에 알린다
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mm.h"
+#include "memlib.h"
+#include "config.h"
+
+#define MIN_ORDER 4                     // 16B, 프리 블록에 pred/succ 포인터 두 개가 들어가는 최소 크기
+#define ORDER_COUNT 32
+#define BLOCK_SIZE(order) (1UL << (order))
+#define LOG2(x) ((int)(sizeof(unsigned long) * 8 - 1) - __builtin_clzl(x))
+
+// order 맵: 블록 시작 오프셋 / 2^MIN_ORDER 위치에 order | BUDDY_FREE. 0이면 블록 시작이 아님
+#define BUDDY_FREE 0x80
+#define ORDER_MASK 0x7f
+#define MAP(off) order_map[(off) >> MIN_ORDER]
+
+#define OFF(p) ((unsigned long)((char *)(p) - heap_base))
+#define PTR(off) (heap_base + (off))
+#define GET_PRED(bp) (*(char **)(bp))
+#define GET_SUCC(bp) (*((char **)(bp) + 1))
+
+team_t team = {
+    "KRAFTON JUNGLE 8th 301",
+    "HYUNJAE LEE",
+    "qnfdlf1997@gmail.com",
+    "",
+    ""
+};
+
+mm_counters_t mm_counters;
+const int mm_thread_safe = 0;   // 전역 상태를 락 없이 고친다
+
+static char *heap_base;                 // 오프셋 0, ALIGNMENT 경계
+static unsigned long heap_end;          // 힙 끝 오프셋
+static char *free_area[ORDER_COUNT];    // order별 프리 리스트 머리
+static unsigned long order_bitmap;      // k번 비트 = free_area[k]가 비어 있지 않음
+static unsigned char order_map[MAX_HEAP >> MIN_ORDER];
+
+static int size_order(size_t size);
+static void push_free(unsigned long off, int order);
+static void pop_free(unsigned long off, int order);
+static void free_merge(unsigned long off, int order);
+static long grow(int order);
+
+int mm_init(void) {
+    char *p = mem_sbrk(0);
+    size_t pad = (ALIGNMENT - (unsigned long)p % ALIGNMENT) % ALIGNMENT;
+
+    if (pad > 0 && mem_sbrk(pad) == (void *)-1)
+        return -1;
+    heap_base = p + pad;
+    heap_end = 0;
+    memset(free_area, 0, sizeof(free_area));
+    order_bitmap = 0;
+    memset(order_map, 0, sizeof(order_map));
+    memset(&mm_counters, 0, sizeof(mm_counters));
+    return 0;
+}
+
+void *mm_malloc(size_t size) {
+    unsigned long candidates, off;
+    int order, k;
+    long grown;
+
+    if (size == 0)
+        return NULL;
+    order = size_order(size);
+    candidates = order_bitmap & (~0UL << order);
+    if (candidates != 0) {
+        k = __builtin_ctzl(candidates);
+        off = OFF(free_area[k]);
+        pop_free(off, k);
+        // 위쪽 반을 프리로 돌려주며 요청 order까지 쪼갠다
+        while (k > order) {
+            k--;
+            push_free(off + BLOCK_SIZE(k), k);
+        }
+    } else {
+        if ((grown = grow(order)) < 0)
+            return NULL;
+        off = grown;
+    }
+    MAP(off) = order;
+    mm_counters.live_block_bytes += BLOCK_SIZE(order);
+    return PTR(off);
+}
+
+void mm_free(void *ptr) {
+    unsigned long off;
+    int order;
+
+    if (ptr == NULL)
+        return;
+    off = OFF(ptr);
+    order = MAP(off) & ORDER_MASK;
+    mm_counters.live_block_bytes -= BLOCK_SIZE(order);
+    free_merge(off, order);
+}
+
+void *mm_realloc(void *ptr, size_t size) {
+    unsigned long off, buddy, end;
+    int order, need, k;
+    void *newptr;
+    size_t copysize;
+
+    if (ptr == NULL)
+        return mm_malloc(size);
+    if (size == 0) {
+        mm_free(ptr);
+        return NULL;
+    }
+    off = OFF(ptr);
+    order = MAP(off) & ORDER_MASK;
+    need = size_order(size);
+    if (need <= order) {
+        // 위쪽 반을 하나씩 떼어 프리로. 그 버디는 아직 할당된 아래쪽 반이라 병합되지 않는다
+        for (k = order; k > need; k--) {
+            MAP(off) = k - 1;
+            free_merge(off + BLOCK_SIZE(k - 1), k - 1);
+        }
+        mm_counters.live_block_bytes -= BLOCK_SIZE(order) - BLOCK_SIZE(need);
+        return ptr;
+    }
+
+    // 먼저 제자리로 need까지 올라갈 수 있는지만 본다. 위쪽 버디가 힙 끝이면 늘려서 쓴다
+    end = heap_end;
+    for (k = order; k < need; k++) {
+        buddy = off ^ BLOCK_SIZE(k);
+        if (buddy < off)
+            break;
+        if (buddy == end)
+            end += BLOCK_SIZE(k);
+        else if (MAP(buddy) != (BUDDY_FREE | k))
+            break;
+    }
+    if (k == need && (end == heap_end || mem_sbrk(end - heap_end) != (void *)-1)) {
+        for (k = order; k < need; k++) {
+            buddy = off ^ BLOCK_SIZE(k);
+            if (buddy < heap_end)
+                pop_free(buddy, k);
+        }
+        heap_end = end;
+        MAP(off) = need;
+        mm_counters.live_block_bytes += BLOCK_SIZE(need) - BLOCK_SIZE(order);
+        return ptr;
+    }
+
+    if ((newptr = mm_malloc(size)) == NULL)
+        return NULL;
+    copysize = BLOCK_SIZE(order);
+    memcpy(newptr, ptr, copysize);
+    mm_free(ptr);
+    mm_counters.realloc_moves++;
+    mm_counters.realloc_copy_bytes += copysize;
+    return newptr;
+}
+
+// 버디 블록은 재활용 여부를 따로 기록하지 않으므로 항상 지운다
+void *mm_calloc(size_t nmemb, size_t size) {
+    void *bp;
+
+    if (size != 0 && nmemb > (size_t)-1 / size)
+        return NULL;
+    if ((bp = mm_malloc(nmemb * size)) != NULL)
+        memset(bp, 0, nmemb * size);
+    return bp;
+}
+
+// 버디 블록 오프셋은 자기 크기의 배수라 order를 align까지 올리면 정렬된다. heap_base가 align 경계가 아니면 NULL
+void *mm_memalign(size_t alignment, size_t size) {
+    if (size == 0 || alignment == 0 || (alignment & (alignment - 1)) != 0
+        || (unsigned long)heap_base % alignment != 0)
+        return NULL;
+    return mm_malloc(size > alignment ? size : alignment);
+}
+
+void *mm_aligned_alloc(size_t alignment, size_t size) {
+    return mm_memalign(alignment, size);
+}
+
+size_t mm_usable_size(void *ptr) {
+    return ptr == NULL ? 0 : BLOCK_SIZE(MAP(OFF(ptr)) & ORDER_MASK);
+}
+
+// 버디는 order별 리스트 머리에서 바로 꺼내고 병합도 버디 한 쌍씩이라 배치로 묶어 얻는 게 없다. 한 개씩 반복
+size_t mm_malloc_batch(void **ptrs, size_t n, size_t size) {
+    size_t i;
+
+    for (i = 0; i < n && (ptrs[i] = mm_malloc(size)) != NULL; i++)
+        ;
+    return i;
+}
+
+void mm_free_batch(void **ptrs, size_t n) {
+    size_t i;
+
+    for (i = 0; i < n; i++)
+        mm_free(ptrs[i]);
+}
+
+// size 바이트가 들어가는 가장 작은 order
+static int size_order(size_t size) {
+    if (size <= BLOCK_SIZE(MIN_ORDER))
+        return MIN_ORDER;
+    return LOG2(size - 1) + 1;
+}
+
+static void push_free(unsigned long off, int order) {
+    char *bp = PTR(off);
+    char *next = free_area[order];
+
+    GET_PRED(bp) = NULL;
+    GET_SUCC(bp) = next;
+    if (next != NULL)
+        GET_PRED(next) = bp;
+    free_area[order] = bp;
+    order_bitmap |= 1UL << order;
+    MAP(off) = BUDDY_FREE | order;
+}
+
+static void pop_free(unsigned long off, int order) {
+    char *bp = PTR(off);
+    char *prev = GET_PRED(bp);
+    char *next = GET_SUCC(bp);
+
+    if (prev != NULL) {
+        GET_SUCC(prev) = next;
+    } else {
+        free_area[order] = next;
+        if (next == NULL)
+            order_bitmap &= ~(1UL << order);
+    }
+    if (next != NULL)
+        GET_PRED(next) = prev;
+    MAP(off) = 0;
+}
+
+// 버디가 같은 order 프리 블록인 동안 합쳐 올라간다. 흡수된 쪽 맵 항목은 pop_free가 지운다
+static void free_merge(unsigned long off, int order) {
+    unsigned long buddy;
+
+    MAP(off) = 0;
+    while (order < ORDER_COUNT - 1) {
+        buddy = off ^ BLOCK_SIZE(order);
+        if (buddy >= heap_end || MAP(buddy) != (BUDDY_FREE | order))
+            break;
+        pop_free(buddy, order);
+        if (buddy < off)
+            off = buddy;
+        order++;
+    }
+    push_free(off, order);
+}
+
+// 힙 끝을 2^order 경계로 올리고 그 위에 order 블록 하나를 새로 만든다. 블록 오프셋, 실패하면 -1.
+// 경계까지의 틈은 자기 정렬에 맞는 가장 큰 블록들로 잘라 프리로 돌린다 (아래 버디와 병합될 수 있음)
+static long grow(int order) {
+    unsigned long start = (heap_end + BLOCK_SIZE(order) - 1) & ~(BLOCK_SIZE(order) - 1);
+    unsigned long off;
+    int k;
+
+    if (mem_sbrk(start + BLOCK_SIZE(order) - heap_end) == (void *)-1)
+        return -1;
+    off = heap_end;
+    heap_end = start + BLOCK_SIZE(order);
+    while (off < start) {
+        k = __builtin_ctzl(off);
+        while (off + BLOCK_SIZE(k) > start)
+            k--;
+        free_merge(off, k);
+        off += BLOCK_SIZE(k);
+    }
+    return start;
+}
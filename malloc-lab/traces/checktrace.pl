@@ -89,29 +89,42 @@ while ($line = <STDIN>) {
 	next;
     }
 
-    if ($cmd eq "a" and $HASH{$id} eq "a") {
-	die "$0: ERROR[$linenum]: allocate with no intervening free.\n";
+    # calloc and aligned alloc requests are checked like alloc requests
+    if ($cmd eq "c" or $cmd eq "m") {
+	$cmd = "a";
     }
 
-    if ($cmd eq "a" and $HASH{$id} eq "f") {
-	die "$0: ERROR[$linenum]: reused ID $id.\n";
+    # a batch request stands for one alloc or free per id in
+    # id .. id+count-1 (the count is the third field)
+    @ids = ($id);
+    if ($cmd eq "A" or $cmd eq "F") {
+	@ids = ($id .. $id + $size - 1);
+	$cmd = ($cmd eq "A") ? "a" : "f";
     }
 
-    if ($cmd eq "f" and !exists($HASH{$id})) {
-	die "$0: ERROR[$linenum]: freeing unallocated block.\n";
-	next;
-    }
+    foreach $id (@ids) {
+	if ($cmd eq "a" and $HASH{$id} eq "a") {
+	    die "$0: ERROR[$linenum]: allocate with no intervening free.\n";
+	}
 
-    if ($cmd eq "f" and !$HASH{$id} eq "f") {
-	die "$0: ERROR[$linenum]: freeing already freed block.\n";
-	next;
-    }
-    
-    if ($cmd eq "f") {
-	delete $HASH{$id};
-    }
-    else {
-	$HASH{$id} = $cmd;
+	if ($cmd eq "a" and $HASH{$id} eq "f") {
+	    die "$0: ERROR[$linenum]: reused ID $id.\n";
+	}
+
+	if ($cmd eq "f" and !exists($HASH{$id})) {
+	    die "$0: ERROR[$linenum]: freeing unallocated block.\n";
+	}
+
+	if ($cmd eq "f" and !$HASH{$id} eq "f") {
+	    die "$0: ERROR[$linenum]: freeing already freed block.\n";
+	}
+
+	if ($cmd eq "f") {
+	    delete $HASH{$id};
+	}
+	else {
+	    $HASH{$id} = $cmd;
+	}
     }
 }
 
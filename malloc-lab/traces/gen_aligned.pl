@@ -0,0 +1,52 @@
+#!/usr/bin/perl
+#!/usr/local/bin/perl
+
+$out_filename = "aligned.rep";
+$num_blocks = 4800;
+$max_live = 400;
+
+# Each request is one of
+#   4 KB aligned I/O buffers of 4-16 KB       (1 in 8)
+#   64 B aligned per-thread counters, 64-512 B (3 in 8)
+#   plain mallocs of 16-256 B                  (4 in 8)
+# and a random live block is freed once max_live blocks are live.
+srand(15213);
+
+for ($i = 0; $i < $num_blocks; $i += 1) {
+    $kind = int(rand 8);
+    if ($kind == 0) {
+        $line = "m $i 4096 " . (4096 * (1 + int(rand 4)) - 16 * int(rand 8));
+    } elsif ($kind <= 3) {
+        $line = "m $i 64 " . (64 * (1 + int(rand 8)));
+    } else {
+        $line = "a $i " . (16 + int(rand 241));
+    }
+    push @trace, $line;
+    push @live, $i;
+    if (@live > $max_live) {
+        $k = int(rand @live);
+        push @trace, "f $live[$k]";
+        splice @live, $k, 1;
+    }
+}
+foreach $id (@live) {
+    push @trace, "f $id";
+}
+
+# Open output file
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+# Calculate misc parameters
+$suggested_heap_size = $max_live * 16384;
+$num_ops = 2*$num_blocks;
+
+print OUTFILE "$suggested_heap_size\n";
+print OUTFILE "$num_blocks\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+
+foreach $line (@trace) {
+    print OUTFILE "$line\n";
+}
+
+close OUTFILE;
@@ -0,0 +1,67 @@
+#!/usr/bin/perl
+#!/usr/local/bin/perl
+
+$out_filename = "batch.rep";
+$num_messages = 600;
+$max_live = 3;
+
+# Each message is parsed into 1-3 batches of 32-384 same-sized nodes
+# (24-264 B) allocated with one batch request, plus 2-4 string buffers
+# of 64-2048 B. Three messages are live at a time; the oldest is
+# dropped with one batch free per node batch. One message in eight is
+# cached and its first node batch lives until the end.
+@node_sizes = (24, 40, 56, 72, 104, 136, 200, 264);
+srand(15213);
+
+$id = 0;
+for ($m = 0; $m < $num_messages; $m += 1) {
+    @frees = ();
+    $batches = 1 + int(rand 3);
+    for ($b = 0; $b < $batches; $b += 1) {
+        $n = 32 + int(rand 353);
+        $size = $node_sizes[int(rand @node_sizes)];
+        push @trace, "A $id $n $size";
+        if ($b == 0 and int(rand 8) == 0) {
+            push @cached, "F $id $n";
+        } else {
+            push @frees, "F $id $n";
+        }
+        $id += $n;
+        if (int(rand 2) == 0) {
+            push @trace, "a $id " . (64 + int(rand 1985));
+            push @frees, "f $id";
+            $id += 1;
+        }
+    }
+    for ($k = 0; $k < 2; $k += 1) {
+        push @trace, "a $id " . (64 + int(rand 1985));
+        push @frees, "f $id";
+        $id += 1;
+    }
+    push @live, [@frees];
+    if (@live > $max_live) {
+        push @trace, @{shift @live};
+    }
+}
+foreach $frees (@live) {
+    push @trace, @$frees;
+}
+push @trace, @cached;
+
+# Open output file
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+# Calculate misc parameters
+$suggested_heap_size = $max_live * 3 * 384 * 264;
+$num_ops = @trace;
+
+print OUTFILE "$suggested_heap_size\n";
+print OUTFILE "$id\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+
+foreach $line (@trace) {
+    print OUTFILE "$line\n";
+}
+
+close OUTFILE;
@@ -0,0 +1,49 @@
+#!/usr/bin/perl
+#!/usr/local/bin/perl
+
+$out_filename = "calloc.rep";
+$num_rounds = 400;
+$table_size = 2048;
+$table_sizes = 16;
+$num_nodes = 8;
+$node_size = 48;
+
+# Open output file
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+# Calculate misc parameters
+#
+# Each round callocs a table that stays live until the end, like the
+# rows of a sparse matrix being built, plus a few small scratch nodes
+# that are freed in the next round. The tables mostly come from fresh
+# heap at the top, the nodes are always recycled.
+
+$ids_per_round = $num_nodes + 1;
+$suggested_heap_size = $num_rounds * $table_size * ($table_sizes + 1) / 2;
+$num_blocks = $num_rounds * $ids_per_round;
+$num_ops = $num_rounds * ($num_nodes + 1) + ($num_rounds - 1) * $num_nodes;
+
+print OUTFILE "$suggested_heap_size\n";
+print OUTFILE "$num_blocks\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+
+for ($i = 0; $i < $num_rounds; $i += 1) {
+	$blk = $i * $ids_per_round;
+	$size = $table_size * (1 + ($i * 7) % $table_sizes);
+	print OUTFILE "c $blk $size\n";
+	for ($j = 1; $j <= $num_nodes; $j += 1) {
+		$blk += 1;
+		$size = $node_size + 16 * ($j % 4);
+		print OUTFILE "c $blk $size\n";
+	}
+
+	if ($i > 0) {
+		for ($j = 1; $j <= $num_nodes; $j += 1) {
+			$prevblk = ($i - 1) * $ids_per_round + $j;
+			print OUTFILE "f $prevblk\n";
+		}
+	}
+}
+
+close OUTFILE;
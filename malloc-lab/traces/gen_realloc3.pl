@@ -0,0 +1,55 @@
+#!/usr/bin/perl
+#!/usr/local/bin/perl
+
+$out_filename = "realloc3.rep";
+$num_bufs = 1200;
+$max_live = 60;
+
+# String builders: each buffer starts at 64 B and grows by about 1.5x
+# with realloc until it passes a target of 256 B - 8 KB, then is shrunk
+# to exactly the target (shrink to fit). Every growth step also
+# allocates a 16-256 B node. A random live buffer or node is freed once
+# max_live of them are live.
+srand(15213);
+
+$id = 0;
+for ($b = 0; $b < $num_bufs; $b += 1) {
+    $buf = $id++;
+    $target = 256 + int(rand 7937);
+    $size = 64;
+    push @trace, "a $buf $size";
+    while ($size < $target) {
+        $size = int($size * 1.5) + 16;
+        push @trace, "r $buf $size";
+        push @trace, "a $id " . (16 + int(rand 241));
+        push @live, $id++;
+    }
+    push @trace, "r $buf $target";
+    push @live, $buf;
+    while (@live > $max_live) {
+        $k = int(rand @live);
+        push @trace, "f $live[$k]";
+        splice @live, $k, 1;
+    }
+}
+foreach $blk (@live) {
+    push @trace, "f $blk";
+}
+
+# Open output file
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+# Calculate misc parameters
+$suggested_heap_size = $max_live * 8192;
+$num_ops = @trace;
+
+print OUTFILE "$suggested_heap_size\n";
+print OUTFILE "$id\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+
+foreach $line (@trace) {
+    print OUTFILE "$line\n";
+}
+
+close OUTFILE;
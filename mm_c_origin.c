@@ -1,245 +0,0 @@
-/*
- * mm-naive.c - The fastest, least memory-efficient malloc package.
- *
- * In this naive approach, a block is allocated by simply incrementing
- * the brk pointer.  A block is pure payload. There are no headers or
- * footers.  Blocks are never coalesced or reused. Realloc is
- * implemented directly using mm_malloc and mm_free.
- *
- * NOTE TO STUDENTS: Replace this header comment with your own header
- * comment that gives a high level description of your solution.
- */
-//헤더
-#include <stdio.h>
-#include <stdlib.h>
-#include <assert.h>
-#include <unistd.h>
-#include <string.h>
-
-#include "mm.h"
-#include "memlib.h"
-
-//매크로(구현용 도구)
-#define WSIZE 4//헤더와 푸터의 크기 = 4바이트
-#define DSIZE 8//더블워드 크기 = 8바이트
-#define CHUNKSIZE (1<<12)//기본 힙 확장 단위(4096바이트)
-#define PACK(size, alloc) ((size)|(alloc))//크기와 할당여부를 합쳐 하나의 워드로 만듦
-#define GET(p) (*(unsigned int *)(p))//메모리에서 읽고
-#define PUT(p, val) (*(unsigned int *)(p)=(val))//쓰고
-#define GET_SIZE(p) (GET(p)&~0x7)//사이즈 추출
-#define GET_ALLOC(p) (GET(p)&0x1)//alloc여부 추출
-#define HDRP(bp) ((char*)(bp)-WSIZE)//블록 포인터로 헤더 찾기
-#define FTRP(bp) ((char*)(bp)+GET_SIZE(HDRP(bp))-DSIZE)//블록 포인터로 푸터 찾기
-#define NEXT_BLKP(bp) ((char*)(bp)+GET_SIZE(((char*)(bp)-WSIZE)))//블록간 이동 앞으로
-#define PREV_BLKP(bp) ((char*)(bp)-GET_SIZE(((char*)(bp)-DSIZE)))//블록간 이동 뒤로
-
-//함수 프로토타입 선언
-static char *heap_listp = 0;
-static void *extend_heap(size_t words);
-static void *coalesce(void *bp);
-static void *find_fit(size_t asize);
-static void place(void *bp, size_t asize);
-
-/*********************************************************
- * NOTE TO STUDENTS: Before you do anything else, please
- * provide your team information in the following struct.
- ********************************************************/
-team_t team = {
-    "KRAFTON JUNGLE 8th 301",
-    "HYUNJAE LEE",
-    "qnfdlf1997@gmail.com",  
-    "",                        
-    ""    
-};
-
-/* single word (4) or double word (8) alignment */
-#define ALIGNMENT 8
-
-/* rounds up to the nearest multiple of ALIGNMENT */
-#define ALIGN(size) (((size) + (ALIGNMENT - 1)) & ~0x7)
-
-#define SIZE_T_SIZE (ALIGN(sizeof(size_t)))
-
-/*
- * mm_init - initialize the malloc package.
- */
-
-//mm_init의 목표는?
-//초기 가용 리스트를 만드는 것
-//힙에 시작 블록과 = prologue block
-//끝 블록을 만든다 = epliogue block
-//그리고 힙을 기본크기만큼 확장한다 = chunksize
-int mm_init(void)
-{
-    if((heap_listp=mem_sbrk(4*WSIZE))==(void*)-1)
-        return -1;
-
-    PUT(heap_listp,0);
-    PUT(heap_listp+(1*WSIZE),PACK(DSIZE,1));
-    PUT(heap_listp+(2*WSIZE),PACK(DSIZE,1));
-    PUT(heap_listp+(3*WSIZE),PACK(0,1));
-    heap_listp+=(2*WSIZE);
-
-    if(extend_heap(CHUNKSIZE/WSIZE)==NULL)
-        return -1;
-
-    return 0;
-}
-
-/*
- * mm_malloc - Allocate a block by incrementing the brk pointer.
- *     Always allocate a block whose size is a multiple of the alignment.
- */
-void *mm_malloc(size_t size)
-{
-    size_t asize;      /* Adjusted block size */
-    size_t extendsize; /* Amount to extend heap if no fit */
-    char *bp;
-
-    /* Ignore spurious requests */
-    if (size == 0)
-        return NULL;
-
-    /* Adjust block size to include overhead and alignment reqs. */
-    if (size <= DSIZE)
-        asize = 2 * DSIZE; // 최소 블록 크기
-    else
-        asize = DSIZE * ((size + (DSIZE) + (DSIZE-1)) / DSIZE);
-
-    /* Search the free list for a fit */
-    if ((bp = find_fit(asize)) != NULL) {
-        place(bp, asize);
-        return bp;
-    }
-
-    /* No fit found. Get more memory and place the block */
-    extendsize = (asize > CHUNKSIZE) ? asize : CHUNKSIZE;
-    if ((bp = extend_heap(extendsize/WSIZE)) == NULL)
-        return NULL;
-    place(bp, asize);
-    return bp;
-}
-
-/*
- * mm_free - Freeing a block does nothing.
- */
-//free의 목표
-//블록포인터가 가리키는 블록을 해제하고
-//붙어있는 가용 블록이 있다면 합친다(병합)
-void mm_free(void *ptr)
-{
-    size_t size = GET_SIZE(HDRP(ptr));
-
-    /* 헤더와 푸터를 Free(alloc = 0)로 설정 */
-    PUT(HDRP(ptr), PACK(size, 0));
-    PUT(FTRP(ptr), PACK(size, 0));
-
-    /* 주변 블록들과 병합 */
-    coalesce(ptr);
-}
-
-/*
- * mm_realloc - Implemented simply in terms of mm_malloc and mm_free
- */
-void *mm_realloc(void *ptr, size_t size)
-{
-    void *oldptr = ptr;
-    void *newptr;
-    size_t copySize;
-
-    newptr = mm_malloc(size);
-    if (newptr == NULL)
-        return NULL;
-    copySize = *(size_t *)((char *)oldptr - SIZE_T_SIZE);
-    if (size < copySize)
-        copySize = size;
-    memcpy(newptr, oldptr, copySize);
-    mm_free(oldptr);
-    return newptr;
-}
-
-static void *extend_heap(size_t words){
-    char *bp;
-    size_t size;
-
-    size=(words%2)?(words+1)*WSIZE:words*WSIZE;
-
-    if((bp=mem_sbrk(size))==(void*)-1)
-        return NULL;
-
-    PUT(HDRP(bp), PACK(size,0));
-    PUT(FTRP(bp), PACK(size,0));
-    PUT(HDRP(NEXT_BLKP(bp)),PACK(0,1));
-
-    return coalesce(bp);
-}
-
-static void *coalesce(void *bp)
-//붙어있는 프리 블록이 있으면 현재 bp블록과 합친다(병합coalesce)
-{
-    size_t prev_alloc = GET_ALLOC(FTRP(PREV_BLKP(bp)));
-    size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
-    size_t size = GET_SIZE(HDRP(bp));
-
-    // Case 1: 앞, 뒤 모두 할당된 상태
-    if (prev_alloc && next_alloc) {
-        return bp;
-    }
-
-    // Case 2: 앞은 할당, 뒤는 가용
-    else if (prev_alloc && !next_alloc) {
-        size += GET_SIZE(HDRP(NEXT_BLKP(bp)));
-        PUT(HDRP(bp), PACK(size, 0));
-        PUT(FTRP(bp), PACK(size, 0));
-    }
-
-    // Case 3: 앞은 가용, 뒤는 할당
-    else if (!prev_alloc && next_alloc) {
-        size += GET_SIZE(HDRP(PREV_BLKP(bp)));
-        PUT(FTRP(bp), PACK(size, 0));
-        PUT(HDRP(PREV_BLKP(bp)), PACK(size, 0));
-        bp = PREV_BLKP(bp); // bp를 앞 블록으로 이동
-    }
-
-    // Case 4: 앞도 가용, 뒤도 가용
-    else {
-        size += GET_SIZE(HDRP(PREV_BLKP(bp))) + GET_SIZE(FTRP(NEXT_BLKP(bp)));
-        PUT(HDRP(PREV_BLKP(bp)), PACK(size, 0));
-        PUT(FTRP(NEXT_BLKP(bp)), PACK(size, 0));
-        bp = PREV_BLKP(bp); // bp를 앞 블록으로 이동
-    }
-
-    return bp;
-}
-
-static void *find_fit(size_t asize)
-{
-    void *bp;
-
-    for (bp = heap_listp; GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp)) {
-        if (!GET_ALLOC(HDRP(bp)) && (asize <= GET_SIZE(HDRP(bp)))) {
-            return bp;
-        }
-    }
-
-    return NULL; // No fit found
-}
-
-static void place(void *bp, size_t asize)
-{
-    size_t csize = GET_SIZE(HDRP(bp));
-
-    if ((csize - asize) >= (2 * DSIZE)) {
-        // 쪼갤 수 있다면
-        PUT(HDRP(bp), PACK(asize, 1));
-        PUT(FTRP(bp), PACK(asize, 1));
-        bp = NEXT_BLKP(bp);
-        PUT(HDRP(bp), PACK(csize - asize, 0));
-        PUT(FTRP(bp), PACK(csize - asize, 0));
-    }
-    else {
-        // 그냥 통째로 사용
-        PUT(HDRP(bp), PACK(csize, 1));
-        PUT(FTRP(bp), PACK(csize, 1));
-    }
-}